@@ -15,6 +15,7 @@
 #endif
 
 #include <solum/solum.h>
+#include <solum/solum_playback.h>
 
 #define PRINT           std::cout << std::endl
 #define PRINTSL         std::cout << "\r"
@@ -27,11 +28,20 @@ static std::string ip_;
 static unsigned int port_ = 0;
 static char buffer_[2048];
 static int counter_ = 0;
+static int queueDepth_ = 0;
+static int socketBuffer_ = 0;
+static std::string tracePath_;
+static std::string recordPath_;
+static solum::Recorder recorder_;
+static std::string playbackPath_;
+static double playbackRate_ = 1.0;
+static solum::Playback playback_;
+static bool quiet_ = false;
 
 /// callback for error messages
 /// @param[in] code the error code
 /// @param[in] err the error message sent from the solum module
-void errorFn(CusErrorCode code, const char* err)
+void errorFn(CusErrorCode code, const char* err, void*)
 {
     ERROR << "error: (" << static_cast<int>(code) << ") " << err;
 }
@@ -40,7 +50,7 @@ void errorFn(CusErrorCode code, const char* err)
 /// @param[in] res connection result
 /// @param[in] port udp port used for streaming
 /// @param[in] status the connection status message sent from the solum module
-void connectFn(CusConnection res, int port, const char* status)
+void connectFn(CusConnection res, int port, const char* status, void*)
 {
     if (res == ConnectionError)
         ERROR << "connection: " << res << ", error: " << status;
@@ -53,7 +63,7 @@ void connectFn(CusConnection res, int port, const char* status)
 
 /// callback for certification status
 /// @param[in] daysValid # of days valid for certificate
-void certFn(int daysValid)
+void certFn(int daysValid, void*)
 {
     if (daysValid == CERT_INVALID)
         ERROR << "certificate invalid or not found";
@@ -66,14 +76,14 @@ void certFn(int daysValid)
 /// callback for probe powering down
 /// @param[in] res power down reason
 /// @param[in] tm time when the probe is powering down
-void powerDownFn(CusPowerDown res, int tm)
+void powerDownFn(CusPowerDown res, int tm, void*)
 {
     PRINT << "probe powering down: " << static_cast<int>(res) << ", in " << tm << "s";
 }
 
 /// callback for software updates
 /// @param[in] res software update result
-void swUpdateFn(CusSwUpdate res)
+void swUpdateFn(CusSwUpdate res, void*)
 {
     if (res == SwUpdateSuccess)
         PRINT << "software update was successful";
@@ -86,7 +96,7 @@ void swUpdateFn(CusSwUpdate res)
 /// callback for imaging state change
 /// @param[in] state imaging ready state
 /// @param[in] imaging 1 = running, 0 = stopped
-void imagingFn(CusImagingState state, int imaging)
+void imagingFn(CusImagingState state, int imaging, void*)
 {
     if (state == ImagingReady)
         PRINT << "ready to image: " << ((imaging) ? "imaging running" : "imaging stopped");
@@ -99,14 +109,14 @@ void imagingFn(CusImagingState state, int imaging)
 /// callback for button press
 /// @param[in] btn the button that was pressed
 /// @param[in] clicks # of clicks used
-void buttonFn(CusButton btn, int clicks)
+void buttonFn(CusButton btn, int clicks, void*)
 {
     PRINT << ((btn == ButtonDown) ? "down" : "up") << " button pressed, clicks: " << clicks;
 }
 
 /// callback for software update progress
 /// @param[in] progress the update progress
-void progressFn(int progress)
+void progressFn(int progress, void*)
 {
     PRINTSL << "updating: " << progress << "%" << std::flush;
 }
@@ -127,7 +137,7 @@ void printImuData(int npos, const CusPosInfo* pos)
 
 /// @brief Receives the update of the imu streaming port
 /// @param port the new imu data UDP streaming port
-void newImuPort(int port)
+void newImuPort(int port, void*)
 {
     if (port != 0)
     {
@@ -141,16 +151,17 @@ void newImuPort(int port)
 
 /// @brief Receives the new imu data streamed from the scanner
 /// @param pos the positional information data streamed
-void newImuData(const CusPosInfo* pos)
+void newImuData(const CusPosInfo* pos, void*)
 {
     PRINT << "imu data streamed:";
     printImuData(1, pos);
+    recorder_.addImu(pos);
 }
 
 /// callback for battery health check
 /// @param[in] res the result
 /// @param[in] val the battery health value
-void batteryHealthFn(CusBatteryHealth res, double val)
+void batteryHealthFn(CusBatteryHealth res, double val, void*)
 {
     if (res == BatteryHealthSuccess)
         PRINT << "battery health: (" << static_cast<int>(val);
@@ -181,8 +192,9 @@ bool printCsv(const char* buf, int sz)
 /// @param[in] nfo the image properties
 /// @param[in] npos the # of positional data points embedded with the frame
 /// @param[in] pos the buffer of positional data
-void newRawImageFn(const void* newImage, const CusRawImageInfo* nfo, int npos, const CusPosInfo* pos)
+void newRawImageFn(const void* newImage, const CusRawImageInfo* nfo, int npos, const CusPosInfo* pos, void*)
 {
+    recorder_.addRaw(newImage, nfo, npos, pos);
 #ifdef PRINTRAW
     if (nfo->rf)
         PRINT << "new rf data (" << newImage << "): " << nfo->lines << " x " << nfo->samples << " @ " << nfo->bitsPerSample
@@ -206,9 +218,11 @@ void newRawImageFn(const void* newImage, const CusRawImageInfo* nfo, int npos, c
 /// @param[in] nfo the image properties
 /// @param[in] npos the # of positional data points embedded with the frame
 /// @param[in] pos the buffer of positional data
-void newProcessedImageFn(const void* newImage, const CusProcessedImageInfo* nfo, int npos, const CusPosInfo* pos)
+void newProcessedImageFn(const void* newImage, const CusProcessedImageInfo* nfo, int npos, const CusPosInfo* pos, void*)
 {
-    (void)newImage;
+    recorder_.addProcessed(newImage, nfo, npos, pos);
+    if (quiet_)
+        return;
     PRINTSL << "new image (" << counter_++ << "): " << nfo->width << " x " << nfo->height << " @ " << nfo->bitsPerPixel << " bpp. @ "
             << nfo->imageSize << "bytes. @ " << nfo->micronsPerPixel << " microns per pixel. imu points: " << npos << std::flush;
 
@@ -216,12 +230,40 @@ void newProcessedImageFn(const void* newImage, const CusProcessedImageInfo* nfo,
         printImuData(npos, pos);
 }
 
+/// pulls processed images from the frame queue until the program quits
+/// @param[in] quit flag to shut down the consumer
+void processFrameQueue(std::atomic_bool& quit)
+{
+    CusQueuedFrame frame;
+    const CusPosInfo* pos = nullptr;
+    int rcode, npos;
+
+    while (!quit)
+    {
+        rcode = solumDequeueFrame(StreamProcessed, 100, &frame);
+        // timed out, check the quit flag and wait again
+        if (rcode == 1)
+            continue;
+        else if (rcode < 0)
+        {
+            ERROR << "frame queue is not enabled";
+            break;
+        }
+
+        npos = solumFramePositions(frame.frame, &pos);
+        newProcessedImageFn(solumFrameData(frame.frame), &frame.processed, (npos > 0) ? npos : 0, pos, nullptr);
+        solumFrameRelease(frame.frame);
+    }
+}
+
 /// processes the user input
 /// @param[out] quit flag to shut down program
 void processEventLoop(std::atomic_bool& quit)
 {
     std::string cmd, buf1, buf2;
     CusStatusInfo stats;
+    CusQueueStats queueStats;
+    CusMetrics metrics;
     CusProbeInfo probe;
     auto connectParams = solumDefaultConnectionParams();
     double v;
@@ -295,7 +337,7 @@ void processEventLoop(std::atomic_bool& quit)
         {
             PRINT << "enter firmware path: ";
             std::getline(std::cin, buf1);
-            if (solumSoftwareUpdate(buf1.c_str(), swUpdateFn, progressFn, 0) < 0)
+            if (solumSoftwareUpdate(buf1.c_str(), swUpdateFn, progressFn, 0, nullptr) < 0)
                 ERROR << "error requesting software update";
         }
         else if (cmd == "G" || cmd == "g")
@@ -304,6 +346,40 @@ void processEventLoop(std::atomic_bool& quit)
                 PRINT << "battery: " << stats.battery << "%, temperature: " << stats.temperature << "%, fr: " << stats.frameRate << "Hz";
             else
                 ERROR << "error requesting status";
+            if (queueDepth_ && solumFrameQueueStats(StreamProcessed, &queueStats) == 0)
+                PRINT << "frame queue: " << queueStats.count << "/" << queueStats.depth << ", queued: " << queueStats.queued
+                      << ", dequeued: " << queueStats.dequeued << ", dropped: " << queueStats.dropped;
+        }
+        else if (cmd == "E" || cmd == "e")
+        {
+            if (solumGetMetrics(&metrics) == 0)
+            {
+                const char* names[CUS_MAXSTREAM] = { "processed", "raw", "spectral" };
+                auto latency = [](const char* name, const CusLatency& l)
+                {
+                    PRINT << "    " << name << ": " << l.mean << "us mean, " << l.max << "us max (" << l.count << " samples)";
+                };
+                PRINT << "metrics over " << (metrics.elapsed / 1000000) << "ms";
+                for (auto i = 0; i < CUS_MAXSTREAM; i++)
+                {
+                    const auto& st = metrics.streams[i];
+                    if (!st.packetsReceived && !st.framesReassembled)
+                        continue;
+                    PRINT << names[i] << ": packets: " << st.packetsReceived << " (" << st.packetsLost << " lost), frames: "
+                          << st.framesReassembled << " (" << st.framesDropped << " dropped), bytes: " << st.bytes;
+                    latency("decode", st.decode);
+                    latency("scan conversion", st.scanConversion);
+                    latency("dispatch", st.dispatch);
+                    latency("end to end", st.endToEnd);
+                }
+            }
+            else
+                ERROR << "error retrieving metrics";
+        }
+        else if (cmd == "Z" || cmd == "z")
+        {
+            if (solumResetMetrics() < 0)
+                ERROR << "error resetting metrics";
         }
         else if (cmd == "I" || cmd == "i")
         {
@@ -331,11 +407,11 @@ void processEventLoop(std::atomic_bool& quit)
         }
         else if (cmd == "P" || cmd == "p")
         {
-            if (solumProbes([](const char* list, int sz)
+            if (solumProbes([](const char* list, int sz, void*)
             {
                 PRINT << "probes:";
                 printCsv(list, sz);
-            }) < 0)
+            }, nullptr) < 0)
                 ERROR << "error requesting probes";
         }
         else if (cmd == "A" || cmd == "a")
@@ -343,10 +419,10 @@ void processEventLoop(std::atomic_bool& quit)
             PRINT << "enter probe model: ";
             std::getline(std::cin, buf1);
             PRINT << "applications for " << buf1 << ":";
-            if (solumApplications(buf1.c_str(), [](const char* list, int sz)
+            if (solumApplications(buf1.c_str(), [](const char* list, int sz, void*)
             {
                 printCsv(list, sz);
-            }) < 0)
+            }, nullptr) < 0)
                 ERROR << "error requesting applications";
         }
         else if (cmd == "L" || cmd == "l")
@@ -412,14 +488,14 @@ void processEventLoop(std::atomic_bool& quit)
         }
         else if (cmd == "B" || cmd == "b")
         {
-            if (solumBatteryHealth(batteryHealthFn) < 0)
+            if (solumBatteryHealth(batteryHealthFn, nullptr) < 0)
                 ERROR << "battery health check failed";
         }
         else
         {
             PRINT << "valid commands: [q: quit, h: help]";
             PRINT << "    connection: [c: connect, d: disconnect]";
-            PRINT << "        manage: [x: load cert, u: software update, g: get status, i: get probe info]";
+            PRINT << "        manage: [x: load cert, u: software update, g: get status, i: get probe info, e: get metrics, z: reset metrics]";
             PRINT << "      workflow: [p: list probes, a: list applications, l: load workflow]";
             PRINT << "       imaging: [r: run imaging, s: stop imaging ]";
             PRINT << "    parameters: [f: fetch parameter, v: set parameter value ]";
@@ -449,6 +525,7 @@ int init(int& argc, char** argv)
 #ifdef _MSC_VER
     namespace po = boost::program_options;
     std::string keydir;
+    auto config = solumDefaultConfig();
 
     try
     {
@@ -458,6 +535,13 @@ int init(int& argc, char** argv)
             ("address", po::value<std::string>(&ip_), "set the IP address of the host scanner")
             ("port", po::value<unsigned int>(&port_), "set the port of the host scanner")
             ("keydir", po::value<std::string>(&keydir)->default_value("/tmp/"), "set the path containing the security keys")
+            ("queue", po::value<int>(&queueDepth_), "pull processed images from a frame queue of the given depth")
+            ("log", "enable solum logging")
+            ("trace", po::value<std::string>(&tracePath_), "write a chrome trace of solum events to the given file")
+            ("rcvbuf", po::value<int>(&socketBuffer_), "set the udp socket receive buffer size in bytes")
+            ("record", po::value<std::string>(&recordPath_), "record the session to the given file")
+            ("playback", po::value<std::string>(&playbackPath_), "play back a recorded session instead of connecting to a scanner")
+            ("rate", po::value<double>(&playbackRate_), "playback rate relative to real-time, 0 to play as fast as possible")
         ;
 
         po::variables_map vm;
@@ -470,6 +554,8 @@ int init(int& argc, char** argv)
         }
 
         po::notify(vm);
+        if (vm.count("log"))
+            config.logLevel = Info;
     }
     catch (std::exception& e)
     {
@@ -484,9 +570,10 @@ int init(int& argc, char** argv)
 #else // every other platform has 'getopt' which we're using so as to not pull in the Boost dependency
     int o;
     std::string keydir = "/tmp/";
+    auto config = solumDefaultConfig();
 
     // check command line options
-    while ((o = getopt(argc, argv, "lk:a:p:")) != -1)
+    while ((o = getopt(argc, argv, "lk:a:p:q:r:f:s:u:t:")) != -1)
     {
         switch (o)
         {
@@ -494,16 +581,38 @@ int init(int& argc, char** argv)
         case 'k': keydir = optarg; break;
         // ip address
         case 'a': ip_ = optarg; break;
-        // port
+        // logging
         case 'l':
             PRINT << "enabling solum logging";
+            config.logLevel = Info;
             break;
+        // tracing
+        case 't': tracePath_ = optarg; break;
+        // port
         case 'p':
             try { port_ = std::stoi(optarg); }
             catch (std::exception&) { PRINT << port_; }
             break;
+        // frame queue depth
+        case 'q':
+            try { queueDepth_ = std::stoi(optarg); }
+            catch (std::exception&) { ERROR << "invalid queue depth specified"; }
+            break;
+        // udp socket receive buffer
+        case 'u':
+            try { socketBuffer_ = std::stoi(optarg); }
+            catch (std::exception&) { ERROR << "invalid socket buffer size specified"; }
+            break;
+        // session recording
+        case 'r': recordPath_ = optarg; break;
+        // session playback
+        case 'f': playbackPath_ = optarg; break;
+        case 's':
+            try { playbackRate_ = std::stod(optarg); }
+            catch (std::exception&) { ERROR << "invalid playback rate specified"; }
+            break;
         // invalid argument
-        case '?': PRINT << "invalid argument, valid options: -a [addr], -p [port], -k [keydir]"; break;
+        case '?': PRINT << "invalid argument, valid options: -a [addr], -p [port], -k [keydir], -l, -t [trace file], -q [queue depth], -u [socket buffer], -r [record file], -f [playback file], -s [playback rate]"; break;
         default: break;
         }
     }
@@ -516,6 +625,25 @@ int init(int& argc, char** argv)
         return ERRCODE;
     }
 
+    if (tracePath_.size())
+    {
+        config.tracePath = tracePath_.c_str();
+        config.traceFormat = TraceChromeJson;
+        PRINT << "tracing solum events to " << tracePath_;
+    }
+    if (solumSetConfig(&config) < 0)
+        ERROR << "could not apply solum configuration";
+
+    if (recordPath_.size())
+    {
+        if (!recorder_.open(recordPath_))
+        {
+            ERROR << "could not open " << recordPath_ << " for recording" << std::endl;
+            return ERRCODE;
+        }
+        PRINT << "recording session to " << recordPath_;
+    }
+
     PRINT << "starting solum program...";
 
     auto initParams = solumDefaultInitParams();
@@ -534,6 +662,27 @@ int init(int& argc, char** argv)
     initParams.errorFn = errorFn;
     initParams.width = width;
     initParams.height = height;
+    initParams.ingest.socketBufferSize = socketBuffer_;
+    // drive the callbacks from a recording without initializing the module
+    if (playbackPath_.size())
+    {
+        // unpaced playback measures throughput, which printing every image would dominate
+        quiet_ = (playbackRate_ <= 0);
+        if (!playback_.open(playbackPath_) || !playback_.start(initParams, playbackRate_))
+        {
+            const char* reason = playback_.reader().error();
+            ERROR << "could not play back " << playbackPath_ << (*reason ? " (" : "") << reason << (*reason ? ")" : "") << std::endl;
+            return ERRCODE;
+        }
+        PRINT << "playing back " << playbackPath_ << " (" << playback_.reader().count() << " chunks)";
+        return SUCCESS;
+    }
+    // processed images are pulled from the queue instead, ensure each queued frame can hold a lease
+    if (queueDepth_ > 0)
+    {
+        initParams.newProcessedImageFn = nullptr;
+        initParams.framePoolDepth = queueDepth_ + 2;
+    }
     // initialize with callbacks
     if (solumInit(&initParams) < 0)
     {
@@ -541,6 +690,12 @@ int init(int& argc, char** argv)
         return ERRCODE;
     }
 
+    if (queueDepth_ > 0 && solumSetFrameQueue(StreamProcessed, queueDepth_, QueueDropOldest) < 0)
+    {
+        ERROR << "could not enable the frame queue" << std::endl;
+        return ERRCODE;
+    }
+
     // try and connect right away if parameters provided
     if (ip_.size() && port_)
     {
@@ -565,9 +720,34 @@ int main(int argc, char* argv[])
     if (rcode != SUCCESS)
         return rcode;
 
+    if (playbackPath_.size())
+    {
+        playback_.wait();
+        auto elapsed = playback_.elapsed();
+        // chunks include imu samples and spectral blocks along with the images
+        PRINT << "played " << playback_.played() << " chunks in " << elapsed << "s";
+        if (elapsed > 0)
+            PRINT << (playback_.played() / elapsed) << " chunks per second";
+        return rcode;
+    }
+
     std::atomic_bool quitFlag(false);
+    std::thread frameQueue;
+    if (queueDepth_ > 0)
+        frameQueue = std::thread(processFrameQueue, std::ref(quitFlag));
     std::thread eventLoop(processEventLoop, std::ref(quitFlag));
     eventLoop.join();
+    if (frameQueue.joinable())
+        frameQueue.join();
     solumDestroy();
+    // finalize the recording once no more callbacks can arrive
+    if (recorder_.isOpen())
+    {
+        auto frames = recorder_.count();
+        if (recorder_.close())
+            PRINT << "recorded " << frames << " frames to " << recordPath_;
+        else
+            ERROR << "error finalizing " << recordPath_;
+    }
     return rcode;
 }
@@ -0,0 +1,255 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <solum/solum_record.h>
+
+#define PRINT           std::cout << std::endl
+#define ERROR           std::cerr << std::endl
+#define ERRCODE         (-1)
+#define SUCCESS         (0)
+
+static std::string input_;
+static std::string output_;
+static int width_ = 640;
+static int height_ = 480;
+static int bpp_ = 8;
+static double fps_ = 30.0;
+static int frames_ = 300;
+static int rawLines_ = 0;
+static int rawSamples_ = 512;
+static bool imu_ = false;
+static double loss_ = 0.0;
+static double jitter_ = 0.0;
+static unsigned int seed_ = 1;
+
+/// applies the configured loss and jitter to a frame
+/// @param[in] rng the random generator
+/// @param[in,out] tm the timestamp to jitter in nanoseconds
+/// @return false if the frame is lost
+static bool degrade(std::mt19937& rng, long long int& tm)
+{
+    if (loss_ > 0 && std::uniform_real_distribution<double>(0.0, 100.0)(rng) < loss_)
+        return false;
+    // negative timestamps would be restamped by the recorder, keep the earliest frames at the start of the timeline
+    if (jitter_ > 0)
+        tm = std::max(0LL, tm + static_cast<long long int>(std::uniform_real_distribution<double>(-jitter_, jitter_)(rng) * 1e6));
+    return true;
+}
+
+/// generates a synthetic session
+/// @param[in] rec the recorder to write to
+/// @return the number of frames written
+static int synthesize(solum::Recorder& rec)
+{
+    std::mt19937 rng(seed_);
+    const long long int period = static_cast<long long int>(1e9 / fps_);
+    const int bytes = bpp_ / 8;
+
+    // speckle is generated once at twice the height and scrolled to emulate motion
+    std::vector<uint8_t> speckle(static_cast<size_t>(width_) * height_ * 2);
+    std::uniform_int_distribution<int> noise(0, 255);
+    for (auto& s : speckle)
+        s = static_cast<uint8_t>(noise(rng));
+
+    std::vector<uint8_t> img(static_cast<size_t>(width_) * height_ * bytes);
+    std::vector<uint8_t> raw(static_cast<size_t>(rawLines_) * rawSamples_);
+    int written = 0;
+
+    for (int f = 0; f < frames_; f++)
+    {
+        long long int tm = period * f;
+        if (!degrade(rng, tm))
+            continue;
+
+        auto scroll = static_cast<size_t>(f % height_) * width_;
+        for (int y = 0; y < height_; y++)
+        {
+            // attenuate with depth
+            int gain = 255 - (y * 192) / height_;
+            auto src = speckle.data() + scroll + static_cast<size_t>(y) * width_;
+            auto dst = img.data() + static_cast<size_t>(y) * width_ * bytes;
+            for (int x = 0; x < width_; x++)
+            {
+                auto v = static_cast<uint8_t>((src[x] * gain) >> 8);
+                if (bytes == 1)
+                    dst[x] = v;
+                else
+                {
+                    dst[x * 4 + 0] = v;
+                    dst[x * 4 + 1] = v;
+                    dst[x * 4 + 2] = v;
+                    dst[x * 4 + 3] = 255;
+                }
+            }
+        }
+
+        CusPosInfo pos;
+        std::memset(&pos, 0, sizeof(pos));
+        pos.tm = tm;
+        pos.az = 1.0;
+        pos.qw = std::cos(f * 0.005);
+        pos.qz = std::sin(f * 0.005);
+
+        CusProcessedImageInfo nfo;
+        std::memset(&nfo, 0, sizeof(nfo));
+        nfo.width = width_;
+        nfo.height = height_;
+        nfo.bitsPerPixel = bpp_;
+        nfo.imageSize = static_cast<int>(img.size());
+        nfo.micronsPerPixel = 100.0;
+        nfo.originX = width_ * 50.0;
+        nfo.tm = tm;
+        nfo.fps = fps_;
+        nfo.format = (bytes == 1) ? Uncompressed8Bit : Uncompressed;
+        rec.addProcessed(img.data(), &nfo, imu_ ? 1 : 0, &pos);
+
+        if (rawLines_)
+        {
+            for (int l = 0; l < rawLines_; l++)
+            {
+                auto src = speckle.data() + scroll + static_cast<size_t>(l % height_) * width_;
+                for (int s = 0; s < rawSamples_; s++)
+                    raw[static_cast<size_t>(l) * rawSamples_ + s] = src[s % width_];
+            }
+            CusRawImageInfo rnfo;
+            std::memset(&rnfo, 0, sizeof(rnfo));
+            rnfo.lines = rawLines_;
+            rnfo.samples = rawSamples_;
+            rnfo.bitsPerSample = 8;
+            rnfo.axialSize = 75.0;
+            rnfo.lateralSize = 300.0;
+            rnfo.tm = tm;
+            rec.addRaw(raw.data(), &rnfo, imu_ ? 1 : 0, &pos);
+        }
+
+        if (imu_)
+            rec.addImu(&pos);
+        written++;
+    }
+
+    return written;
+}
+
+/// rewrites a recorded session with the configured loss and jitter applied
+/// @param[in] rec the recorder to write to
+/// @return the number of frames written, -1 if the input could not be read
+static int degradeRecording(solum::Recorder& rec)
+{
+    solum::RecordReader reader;
+    if (!reader.open(input_))
+    {
+        ERROR << "could not read " << input_ << " (" << reader.error() << ")";
+        return ERRCODE;
+    }
+
+    std::mt19937 rng(seed_);
+    solum::RecordedFrame frame;
+    int written = 0;
+
+    for (size_t i = 0; i < reader.count(); i++)
+    {
+        if (!reader.frame(i, frame))
+            continue;
+        // imu samples are streamed separately and left untouched
+        if (frame.stream == solum::RecordImu)
+        {
+            for (int s = 0; frame.pos && s < frame.npos; s++)
+                rec.addImu(&frame.pos[s]);
+            continue;
+        }
+
+        long long int tm = frame.tm;
+        if (!degrade(rng, tm))
+            continue;
+
+        if (frame.stream == solum::RecordProcessed)
+        {
+            auto nfo = *frame.processed();
+            nfo.tm = tm;
+            rec.addProcessed(frame.data, &nfo, frame.npos, frame.pos);
+        }
+        else if (frame.stream == solum::RecordRaw)
+        {
+            auto nfo = *frame.raw();
+            nfo.tm = tm;
+            rec.addRaw(frame.data, &nfo, frame.npos, frame.pos);
+        }
+        else if (frame.stream == solum::RecordSpectral)
+            rec.addSpectral(frame.data, frame.spectral());
+        written++;
+    }
+
+    return written;
+}
+
+/// main entry point
+/// @param[in] argc # of program arguments
+/// @param[in] argv list of arguments
+int main(int argc, char* argv[])
+{
+    int o;
+    const char* usage = "usage: -o [output] -i [input recording] -w [width] -h [height] -b [bits per pixel] -r [fps] -n [frames] "
+        "-R [raw lines] -S [raw samples] -m (imu) -l [loss %] -j [jitter ms] -s [seed]";
+
+    try
+    {
+        while ((o = getopt(argc, argv, "o:i:w:h:b:r:n:R:S:ml:j:s:")) != -1)
+        {
+            switch (o)
+            {
+            case 'o': output_ = optarg; break;
+            case 'i': input_ = optarg; break;
+            case 'w': width_ = std::stoi(optarg); break;
+            case 'h': height_ = std::stoi(optarg); break;
+            case 'b': bpp_ = std::stoi(optarg); break;
+            case 'r': fps_ = std::stod(optarg); break;
+            case 'n': frames_ = std::stoi(optarg); break;
+            case 'R': rawLines_ = std::stoi(optarg); break;
+            case 'S': rawSamples_ = std::stoi(optarg); break;
+            case 'm': imu_ = true; break;
+            case 'l': loss_ = std::stod(optarg); break;
+            case 'j': jitter_ = std::stod(optarg); break;
+            case 's': seed_ = static_cast<unsigned int>(std::stoul(optarg)); break;
+            default: ERROR << usage; return ERRCODE;
+            }
+        }
+    }
+    catch (std::exception&)
+    {
+        ERROR << "invalid argument, " << usage;
+        return ERRCODE;
+    }
+
+    if (!output_.size() || width_ <= 0 || height_ <= 0 || (bpp_ != 8 && bpp_ != 32) || fps_ <= 0 || rawLines_ < 0 || rawSamples_ <= 0)
+    {
+        ERROR << usage;
+        return ERRCODE;
+    }
+
+    solum::Recorder rec;
+    if (!rec.open(output_))
+    {
+        ERROR << "could not open " << output_;
+        return ERRCODE;
+    }
+
+    int written = input_.size() ? degradeRecording(rec) : synthesize(rec);
+    if (written < 0)
+        return ERRCODE;
+
+    if (!rec.close())
+    {
+        ERROR << "error writing " << output_;
+        return ERRCODE;
+    }
+
+    PRINT << "wrote " << written << " frames to " << output_ << std::endl;
+    return SUCCESS;
+}
@@ -1,9 +1,15 @@
 #include "display.h"
 #include <solum/solum.h>
+#ifdef SOLUM_JPEG
+#include <solum/solum_jpeg.h>
+
+// decoder shared by the displays, which are all updated from the gui thread
+static solum::JpegDecoder _jpeg;
+#endif
 
 /// default constructor
 /// @param[in] parent the parent object
-UltrasoundImage::UltrasoundImage(bool overlay, QWidget* parent) : QGraphicsView(parent), depth_(0), overlay_(overlay)
+UltrasoundImage::UltrasoundImage(bool overlay, QWidget* parent) : QGraphicsView(parent), depth_(0), overlay_(overlay), pending_(), hasPending_(false), generation_(0)
 {
     QGraphicsScene* sc = new QGraphicsScene(this);
     setScene(sc);
@@ -25,11 +31,12 @@ UltrasoundImage::UltrasoundImage(bool overlay, QWidget* parent) : QGraphicsView(
 /// @param[in] bpp bits per pixel
 /// @param[in] format the image format
 /// @param[in] sz size of image in bytes
-void UltrasoundImage::loadImage(const void* img, int w, int h, int bpp, CusImageFormat format, int sz)
+/// @param[in] generation the generation of the geometry the image was produced with
+void UltrasoundImage::loadImage(const void* img, int w, int h, int bpp, CusImageFormat format, int sz, long long int generation)
 {
-    // check for size match
+    // adopt the size of the frame, which lags the display size while a resize is pending
     if (image_.width() != w || image_.height() != h)
-        return;
+        image_ = QImage(w, h, (format == Uncompressed8Bit) ? QImage::Format_Grayscale8 : QImage::Format_ARGB32);
 
     // ensure the qimage format matches
     if (format == Uncompressed8Bit && image_.format() != QImage::Format_Grayscale8)
@@ -41,67 +48,72 @@ void UltrasoundImage::loadImage(const void* img, int w, int h, int bpp, CusImage
     // check that the size matches the dimensions (uncompressed)
     if (sz >= (w * h * (bpp / 8)))
         std::memcpy(image_.bits(), img, w * h * (bpp / 8));
-    // try to load jpeg
+    // try to load jpeg, decoding in place when possible to avoid allocating a new image every frame
     else if (format == Jpeg)
-        image_.loadFromData(static_cast<const uchar*>(img), sz, "JPG");
+    {
+#ifdef SOLUM_JPEG
+        if (!_jpeg.decode(img, static_cast<size_t>(sz), image_.bits(), w, h, static_cast<size_t>(image_.bytesPerLine()), solum::JpegDecoder::Argb))
+#endif
+            image_.loadFromData(static_cast<const uchar*>(img), sz, "JPG");
+    }
     else if (format == Png)
         image_.loadFromData(static_cast<const uchar*>(img), sz, "PNG");
 
+    // switch the overlays over along with the first frame produced with the new geometry
+    generation_ = generation;
+    if (hasPending_ && generation_ >= pending_.generation)
+        flushGeometry();
+
     // redraw
     scene()->invalidate();
 }
 
-/// checks if there's a valid roi that should be drawn
-void UltrasoundImage::checkActiveRegion()
+/// applies the geometry reported by the library
+/// @param[in] geometry the geometry to apply
+/// @param[in] immediate flag to apply the geometry right away rather than with the first frame produced with it
+void UltrasoundImage::applyGeometry(const CusGeometry& geometry, bool immediate)
 {
-    // make room for 4 x/y points
-    double buf[8];
-    // for sector probes, the first 2 and the last 2 points, along with the radius of curvature, should be used to calculate an arc if necessary
-    // qt supports a drawArc() function which could be useful for portraying this
-    if (solumGetActiveRegion(buf, 4) == 0)
-    {
-        QPolygonF roi;
-        for (auto i = 0u; i < 4; i++)
-            roi.push_back(QPointF(buf[i * 2], buf[(i * 2) + 1]));
-        activeRoi_ = roi;
-    }
+    pending_ = geometry;
+    hasPending_ = true;
+    if (immediate || generation_ >= geometry.generation)
+        flushGeometry();
 }
 
-/// checks if there's a valid roi that should be drawn
-void UltrasoundImage::checkRoi()
+/// updates the overlays from the pending geometry
+void UltrasoundImage::flushGeometry()
 {
-    // make room for 32 x/y points
-    double buf[64];
-    if (solumGetRoi(buf, 32) == 0)
+    if (!hasPending_)
+        return;
+    hasPending_ = false;
+    const auto& geometry = pending_;
+
+    auto convertLine = [](const CusLineF& line) -> QLineF
+    {
+        return QLineF(QPointF(line.p1.x, line.p1.y), QPointF(line.p2.x, line.p2.y));
+    };
+
+    activeRoi_.clear();
+    for (auto i = 0u; i < 4; i++)
+        activeRoi_.push_back(QPointF(geometry.activeRegion[i].x, geometry.activeRegion[i].y));
+
+    modeRoi_.clear();
+    if (geometry.roi)
     {
-        QPolygonF roi;
-        for (auto i = 0u; i < 32; i++)
-            roi.push_back(QPointF(buf[i * 2], buf[(i * 2) + 1]));
-        modeRoi_ = roi;
+        for (auto i = 0u; i < CUS_MAXROI; i++)
+            modeRoi_.push_back(QPointF(geometry.roiPoints[i].x, geometry.roiPoints[i].y));
     }
-    else
-        modeRoi_.clear();
-}
 
-/// checks if there's a valid gate that should be drawn
-void UltrasoundImage::checkGate()
-{
-    CusGateLines lines;
-    if (solumGetGate(&lines) == 0)
+    gate_.clear();
+    if (geometry.gate)
     {
-        auto convertLine = [](const CusLineF& line) -> QLineF
-        {
-            return QLineF(QPointF(line.p1.x, line.p1.y), QPointF(line.p2.x, line.p2.y));
-        };
-        gate_.clear();
-        gate_.push_back(convertLine(lines.active));
-        gate_.push_back(convertLine(lines.top));
-        gate_.push_back(convertLine(lines.normalTop));
-        gate_.push_back(convertLine(lines.normalBottom));
-        gate_.push_back(convertLine(lines.bottom));
+        gate_.push_back(convertLine(geometry.gateLines.active));
+        gate_.push_back(convertLine(geometry.gateLines.top));
+        gate_.push_back(convertLine(geometry.gateLines.normalTop));
+        gate_.push_back(convertLine(geometry.gateLines.normalBottom));
+        gate_.push_back(convertLine(geometry.gateLines.bottom));
     }
-    else
-        gate_.clear();
+
+    scene()->invalidate();
 }
 
 /// handles resizing of the image view
@@ -111,22 +123,10 @@ void UltrasoundImage::resizeEvent(QResizeEvent* e)
     auto w = e->size().width(), h = e->size().height();
 
     setSceneRect(0, 0, w, h);
+    // frames keep arriving at the current size until the library has switched over, at which point the new geometry is sent
+    // to the long-lived gui object through the init geometry callback, never to this view, which may be gone by then
     if (!overlay_)
-        solumSetOutputSize(w, h);
-
-    image_ = QImage(w, h, QImage::Format_ARGB32);
-    image_.fill(Qt::black);
-
-    // update the roi in the case of a resize
-    if (!overlay_)
-    {
-        QTimer::singleShot(250, [this]()
-        {
-            checkActiveRegion();
-            checkRoi();
-            checkGate();
-        });
-    }
+        solumRequestOutputSize(w, h, nullptr, nullptr);
 
     QGraphicsView::resizeEvent(e);
 }
@@ -206,19 +206,13 @@ void UltrasoundImage::mouseReleaseEvent(QMouseEvent* e)
     if (overlay_)
         return;
 
-    // if the call to move succeeds, it means an imaging mode supporting an roi is running
+    // the adjusted roi or gate is reported through the geometry callback
     auto pos = e->position();
     auto m = solumGetMode();
     if (m == ColorMode || m == PowerMode || m == Strain || m == RfMode)
-    {
-        if (solumAdjustRoi(static_cast<int>(pos.x()), static_cast<int>(pos.y()), (e->button() == Qt::LeftButton) ? MoveRoi : SizeRoi) == 0)
-            checkRoi();
-    }
+        solumAdjustRoi(static_cast<int>(pos.x()), static_cast<int>(pos.y()), (e->button() == Qt::LeftButton) ? MoveRoi : SizeRoi);
     else if (m == MMode || m == PwMode)
-    {
-        if (solumAdjustGate(static_cast<int>(pos.x()), static_cast<int>(pos.y())) == 0)
-            checkGate();
-    }
+        solumAdjustGate(static_cast<int>(pos.x()), static_cast<int>(pos.y()));
 
     QWidget::mouseReleaseEvent(e);
 }
@@ -328,7 +322,7 @@ void Spectrum::drawForeground(QPainter* painter, const QRectF& r)
 
 /// default constructor
 /// @param[in] parent the parent object
-RfSignal::RfSignal(QWidget* parent) : QGraphicsView(parent), zoom_(0.1)
+RfSignal::RfSignal(QWidget* parent) : QGraphicsView(parent), rf_(1), zoom_(0.1)
 {
     QGraphicsScene* sc = new QGraphicsScene(this);
     setScene(sc);
@@ -346,7 +340,8 @@ RfSignal::RfSignal(QWidget* parent) : QGraphicsView(parent), zoom_(0.1)
 /// @param[in] l # of rf lines
 /// @param[in] s # of samples per line
 /// @param[in] ss sample size in bytes
-void RfSignal::loadSignal(const void* rf, int l, int s, int ss)
+/// @param[in] axial axial microns per sample
+void RfSignal::loadSignal(const void* rf, int l, int s, int ss, double axial)
 {
     if (!rf || !l || !s || ss != 2)
         return;
@@ -355,7 +350,20 @@ void RfSignal::loadSignal(const void* rf, int l, int s, int ss)
     signal_.clear();
     const int16_t* buf = static_cast<const int16_t*>(rf) + ((l / 2) * s);
     for (auto i = 0; i < s; i++)
-        signal_.push_back(*buf++);
+        signal_.push_back(buf[i]);
+
+    // detect the envelope of the line
+    CusRawImageInfo nfo = {};
+    nfo.lines = 1;
+    nfo.samples = s;
+    nfo.bitsPerSample = 16;
+    nfo.axialSize = axial;
+    nfo.rf = 1;
+    envelope_.resize(s);
+    if (rf_.configure(nfo, solum::defaultRfParams()))
+        rf_.envelope(buf, envelope_.data());
+    else
+        envelope_.clear();
 
     // redraw
     scene()->invalidate();
@@ -424,6 +432,21 @@ void RfSignal::drawForeground(QPainter* painter, const QRectF& r)
             x = x + sampleSize;
         }
     }
+
+    if (!envelope_.isEmpty())
+    {
+        painter->setPen(QColor(255, 255, 0));
+        qreal x = 0, baseline = r.height() / 2;
+        double sampleSize = static_cast<double>(r.width()) / static_cast<double>(envelope_.size());
+        QPointF p(x, baseline + envelope_[0] * zoom_);
+        for (auto e : envelope_)
+        {
+            QPointF pt(x + sampleSize, baseline + e * zoom_);
+            painter->drawLine(p, pt);
+            p = pt;
+            x = x + sampleSize;
+        }
+    }
 }
 
 /// default constructor
@@ -458,7 +481,13 @@ void Prescan::loadImage(const void* img, int w, int h, int bpp, CusImageFormat f
     }
 
     if (format == Jpeg)
-        image_.loadFromData(static_cast<const uchar*>(img), sz, "JPG");
+    {
+#ifdef SOLUM_JPEG
+        // the image holds samples across and lines down
+        if (!_jpeg.decode(img, static_cast<size_t>(sz), image_.bits(), h, w, static_cast<size_t>(image_.bytesPerLine()), solum::JpegDecoder::Gray))
+#endif
+            image_.loadFromData(static_cast<const uchar*>(img), sz, "JPG");
+    }
     else
         std::memcpy(image_.bits(), img, w * h * (bpp / 8));
 
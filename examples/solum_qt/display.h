@@ -1,6 +1,7 @@
 #pragma once
 
 #include <solum/solum_def.h>
+#include <solum/solum_rf.h>
 
 /// ultrasound image display
 class UltrasoundImage : public QGraphicsView
@@ -9,11 +10,10 @@ class UltrasoundImage : public QGraphicsView
 public:
     explicit UltrasoundImage(bool overlay, QWidget*);
 
-    void loadImage(const void* img, int w, int h, int bpp, CusImageFormat format, int sz);
+    void loadImage(const void* img, int w, int h, int bpp, CusImageFormat format, int sz, long long int generation);
     void setDepth(double d) { depth_ = d; }
-    void checkActiveRegion();
-    void checkRoi();
-    void checkGate();
+    void applyGeometry(const CusGeometry& geometry, bool immediate);
+    void flushGeometry();
 
 protected:
     virtual void drawForeground(QPainter*, const QRectF&) override;
@@ -30,6 +30,9 @@ private:
     QPolygonF activeRoi_;   ///< active region for grayscale imaging
     QPolygonF modeRoi_;     ///< region of interest for doppler or elastography modes
     QVector<QLineF> gate_;  ///< gate lines to draw
+    CusGeometry pending_;   ///< latest geometry reported, waiting for a frame produced with it
+    bool hasPending_;       ///< flag if the pending geometry has yet to be applied
+    long long int generation_; ///< geometry generation of the latest frame
     QImage image_;          ///< the image buffer
 };
 
@@ -63,7 +66,7 @@ class RfSignal : public QGraphicsView
 public:
     explicit RfSignal(QWidget*);
 
-    void loadSignal(const void* rf, int l, int s, int ss);
+    void loadSignal(const void* rf, int l, int s, int ss, double axial);
     void setZoom(int zoom);
 
 protected:
@@ -76,6 +79,8 @@ protected:
 
 private:
     QVector<int16_t> signal_;   ///< the rf signal
+    QVector<float> envelope_;   ///< envelope of the rf signal
+    solum::RfProcessor rf_;     ///< detects the envelope of the displayed line
     qreal zoom_;                ///< zoom level
 };
 
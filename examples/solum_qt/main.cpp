@@ -1,13 +1,13 @@
 #include "solumqt.h"
 #include <memory>
 #include <solum/solum.h>
+#include <solum/solum_imu.h>
 #include <iostream>
 
-static std::unique_ptr<Solum> _solum;
-static std::vector<char> _image;
 static std::vector<char> _prescanImage;
 static std::vector<char> _spectrum;
 static std::vector<char> _rfData;
+static solum::ImuBuffer _imu;
 
 void printFirmwareVersions()
 {
@@ -38,7 +38,7 @@ int main(int argc, char *argv[])
     const int width  = 640; // width of the rendered image
     const int height = 480; // height of the rendered image
 
-    _solum = std::make_unique<Solum>();
+    auto solum = std::make_unique<Solum>();
 
     auto storeDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation).toLocal8Bit();
     auto initParams = solumDefaultInitParams();
@@ -47,43 +47,48 @@ int main(int argc, char *argv[])
     initParams.storeDir = storeDir.constData();
     initParams.width = width;
     initParams.height = height;
+    // the grayscale and overlay mailboxes can each hold on to 3 frames
+    initParams.framePoolDepth = 8;
+    // every callback gets handed the gui object to post its events to
+    initParams.userData = solum.get();
 
     initParams.connectFn =
-        [](CusConnection res, int port, const char* msg)
+        [](CusConnection res, int port, const char* msg, void* user)
         {
-            QApplication::postEvent(_solum.get(), new event::Connection(res, port, QString::fromLatin1(msg)));
+            QApplication::postEvent(static_cast<Solum*>(user), new event::Connection(res, port, QString::fromLatin1(msg)));
         };
 
     initParams.certFn =
-        [](int daysValid)
+        [](int daysValid, void* user)
         {
-            QApplication::postEvent(_solum.get(), new event::Cert(daysValid));
+            QApplication::postEvent(static_cast<Solum*>(user), new event::Cert(daysValid));
         };
 
     initParams.powerDownFn =
-        [](CusPowerDown res, int tm)
+        [](CusPowerDown res, int tm, void* user)
         {
-            QApplication::postEvent(_solum.get(), new event::PowerDown(res, tm));
+            QApplication::postEvent(static_cast<Solum*>(user), new event::PowerDown(res, tm));
         };
 
-    initParams.newProcessedImageFn =
-        [](const void* img, const CusProcessedImageInfo* nfo, int npos, const CusPosInfo* pos)
+    initParams.newFrameFn =
+        [](CusFrame* frame, const CusProcessedImageInfo* nfo, int npos, const CusPosInfo* pos, void* user)
         {
-            int sz = nfo->imageSize;
-            // we need to perform a deep copy of the image data since we have to post the event (yes this happens a lot with this api)
-            if (_image.size() < static_cast<size_t>(sz))
-                _image.resize(sz);
-            std::memcpy(_image.data(), img, sz);
             QQuaternion imu;
             imu.setScalar(0.0);
-            if (npos && pos)
-                imu = QQuaternion(static_cast<float>(pos[0].qw), static_cast<float>(pos[0].qx), static_cast<float>(pos[0].qy), static_cast<float>(pos[0].qz));
-
-            QApplication::postEvent(_solum.get(), new event::Image(IMAGE_EVENT, _image.data(), nfo->width, nfo->height, nfo->bitsPerPixel, nfo->format, sz, nfo->overlay, imu));
+            // the samples sent along with a frame are buffered such that the orientation can be interpolated at the frame time,
+            // the buffer being fed from this callback only, as the imu data callback may run on another thread
+            _imu.push(pos, npos);
+            CusPosInfo p;
+            // fall back to the newest sample when the frame lies too far beyond the samples
+            if (_imu.pose(nfo->tm, p) || _imu.latest(p))
+                imu = QQuaternion(static_cast<float>(p.qw), static_cast<float>(p.qx), static_cast<float>(p.qy), static_cast<float>(p.qz));
+
+            // the gui only ever renders the latest complete image, frames it cannot keep up with are skipped
+            static_cast<Solum*>(user)->publishImage(frame, nfo, imu);
         };
 
     initParams.newRawImageFn =
-        [](const void* data, const CusRawImageInfo* nfo, int, const CusPosInfo*)
+        [](const void* data, const CusRawImageInfo* nfo, int, const CusPosInfo*, void* user)
         {
             // we need to perform a deep copy of the image data since we have to post the event (yes this happens a lot with this api)
             int sz = nfo->lines * nfo->samples * (nfo->bitsPerSample / 8);
@@ -92,7 +97,7 @@ int main(int argc, char *argv[])
                 if (_rfData.size() < static_cast<size_t>(sz))
                     _rfData.resize(sz);
                 std::memcpy(_rfData.data(), data, sz);
-                QApplication::postEvent(_solum.get(), new event::RfImage(_rfData.data(), nfo->lines, nfo->samples, nfo->bitsPerSample, sz,
+                QApplication::postEvent(static_cast<Solum*>(user), new event::RfImage(_rfData.data(), nfo->lines, nfo->samples, nfo->bitsPerSample, sz,
                                                                             nfo->lateralSize, nfo->axialSize));
             }
             else
@@ -103,64 +108,70 @@ int main(int argc, char *argv[])
                 if (_prescanImage.size() < static_cast<size_t>(sz))
                     _prescanImage.resize(sz);
                 std::memcpy(_prescanImage.data(), data, sz);
-                QApplication::postEvent(_solum.get(), new event::Image(PRESCAN_EVENT, _prescanImage.data(), nfo->lines, nfo->samples,
+                QApplication::postEvent(static_cast<Solum*>(user), new event::Image(PRESCAN_EVENT, _prescanImage.data(), nfo->lines, nfo->samples,
                                                                        nfo->bitsPerSample, nfo->jpeg ? Jpeg : Uncompressed8Bit, sz, false, QQuaternion()));
             }
         };
 
     initParams.newSpectralImageFn =
-        [](const void* img, const CusSpectralImageInfo* nfo)
+        [](const void* img, const CusSpectralImageInfo* nfo, void* user)
         {
             size_t sz = nfo->lines * nfo->samples * (nfo->bitsPerSample / 8);
             // we need to perform a deep copy of the spectrum data since we have to post the event (yes this happens a lot with this api)
             if (_spectrum.size() < sz)
                 _spectrum.resize(sz);
             std::memcpy(_spectrum.data(), img, sz);
-            QApplication::postEvent(_solum.get(), new event::SpectrumImage(_spectrum.data(), nfo->lines, nfo->samples, nfo->bitsPerSample));
+            QApplication::postEvent(static_cast<Solum*>(user), new event::SpectrumImage(_spectrum.data(), nfo->lines, nfo->samples, nfo->bitsPerSample));
     };
 
     initParams.newImuPortFn =
-        [](int port)
+        [](int port, void* user)
         {
-            QApplication::postEvent(_solum.get(), new event::ImuPort(port));
+            QApplication::postEvent(static_cast<Solum*>(user), new event::ImuPort(port));
         };
 
     initParams.newImuDataFn =
-        [](const CusPosInfo* pos)
+        [](const CusPosInfo* pos, void* user)
         {
             QQuaternion imu;
             imu.setScalar(0.0);
             if (pos)
                 imu = QQuaternion(static_cast<float>(pos->qw), static_cast<float>(pos->qx), static_cast<float>(pos->qy), static_cast<float>(pos->qz));
-            QApplication::postEvent(_solum.get(), new event::Imu(imu));
+            QApplication::postEvent(static_cast<Solum*>(user), new event::Imu(imu));
+        };
+
+    initParams.geometryFn =
+        [](const CusGeometry* geometry, void* user)
+        {
+            QApplication::postEvent(static_cast<Solum*>(user), new event::Geometry(*geometry));
         };
 
     initParams.imagingFn =
-        [](CusImagingState state, int imaging)
+        [](CusImagingState state, int imaging, void* user)
         {
             // post event here, as the gui (statusbar) will be updated directly, and it needs to come from the application thread
-            QApplication::postEvent(_solum.get(), new event::Imaging(state, imaging ? true : false));
+            QApplication::postEvent(static_cast<Solum*>(user), new event::Imaging(state, imaging ? true : false));
         };
 
     initParams.buttonFn =
-        [](CusButton btn, int clicks)
+        [](CusButton btn, int clicks, void* user)
         {
             // post event here, as the gui (statusbar) will be updated directly, and it needs to come from the application thread
-            QApplication::postEvent(_solum.get(), new event::Button(btn, clicks));
+            QApplication::postEvent(static_cast<Solum*>(user), new event::Button(btn, clicks));
         };
 
     initParams.errorFn =
-        [](CusErrorCode code, const char* err)
+        [](CusErrorCode code, const char* err, void* user)
         {
             // post event here, as the gui (statusbar) will be updated directly, and it needs to come from the application thread
-            QApplication::postEvent(_solum.get(), new event::Error(code, err));
+            QApplication::postEvent(static_cast<Solum*>(user), new event::Error(code, err));
     };
 
     initParams.elemTestFn  =
-        [](CusElementTest res, double val)
+        [](CusElementTest res, double val, void* user)
     {
         // post event here, as the gui (statusbar) will be updated directly, and it needs to come from the application thread
-        QApplication::postEvent(_solum.get(), new event::ElementTest(res, val));
+        QApplication::postEvent(static_cast<Solum*>(user), new event::ElementTest(res, val));
     };
 
     if (solumInit(&initParams) != CUS_SUCCESS)
@@ -170,18 +181,18 @@ int main(int argc, char *argv[])
     }
 
     solumSetTeeFn(
-        [](bool connected, const char* serial, double timeRemaining, const char* id, const char* name, const char* exam)
+        [](bool connected, const char* serial, double timeRemaining, const char* id, const char* name, const char* exam, void* user)
         {
             // post event here, as the gui (statusbar) will be updated directly, and it needs to come from the application thread
-            QApplication::postEvent(_solum.get(), new event::Tee(connected, QString::fromLatin1(serial), timeRemaining,
+            QApplication::postEvent(static_cast<Solum*>(user), new event::Tee(connected, QString::fromLatin1(serial), timeRemaining,
                 QString::fromLatin1(id), QString::fromLatin1(name), QString::fromLatin1(exam)));
         });
 
     printFirmwareVersions();
 
-    _solum->show();
+    solum->show();
     const int result = a.exec();
     solumDestroy();
-    _solum.reset();
+    solum.reset();
     return result;
 }
@@ -10,6 +10,13 @@ LIBPATH = $$PWD/../../lib
 INCLUDEPATH += $$PWD/../../include
 LIBS += -L$$LIBPATH/ -lsolum
 
+# decode compressed images with libjpeg(-turbo) when available, otherwise qt's image loader is used
+CONFIG += link_pkgconfig
+packagesExist(libjpeg) {
+    PKGCONFIG += libjpeg
+    DEFINES += SOLUM_JPEG
+}
+
 SOURCES += main.cpp solumqt.cpp ble.cpp display.cpp 3d.cpp
 HEADERS += solumqt.h ble.h display.h 3d.h
 FORMS += solumqt.ui
@@ -3,20 +3,20 @@
 #include "3d.h"
 #include "ui_solumqt.h"
 #include <solum/solum.h>
+#include <thread>
 
 #define RAW_TAB         3
 #define IMU_TAB         4
 #define UPDATE_PROGRESS 0
 #define RAW_PROGRESS    1
+#define RAW_RESUMES     3
+#define RAW_RETRIES     3
 #define MB_CONV         (1024.0 * 1024.0)
 
-static Solum* _me;
-
 /// default constructor
 /// @param[in] parent the parent object
-Solum::Solum(QWidget *parent) : QMainWindow(parent), connected_(false), imaging_(false), teeConnected_(false), imuSamples_(0), acquired_(0), ui_(new Ui::Solum)
+Solum::Solum(QWidget *parent) : QMainWindow(parent), connected_(false), imaging_(false), teeConnected_(false), imuSamples_(0), acquired_(0), ui_(new Ui::Solum), imagePending_(false), closing_(false), publishing_(0)
 {
-    _me = this;
     ui_->setupUi(this);
     setWindowIcon(QIcon(":/res/logo.png"));
     image_ = new UltrasoundImage(false, this);
@@ -103,10 +103,10 @@ Solum::Solum(QWidget *parent) : QMainWindow(parent), connected_(false), imaging_
     });
 
     // load probes list
-    solumProbes([](const char* list, int)
+    solumProbes([](const char* list, int, void* user)
     {
-        QApplication::postEvent(_me, new event::List(list, true));
-    });
+        QApplication::postEvent(static_cast<Solum*>(user), new event::List(list, true));
+    }, this);
 
     ui_->modes->blockSignals(true);
     ui_->modes->addItem(QStringLiteral("B"));
@@ -145,7 +145,15 @@ Solum::Solum(QWidget *parent) : QMainWindow(parent), connected_(false), imaging_
     {
         double total = static_cast<double>(acquired_) / MB_CONV;
         double br = ((static_cast<double>(acquired_ * 8.0) / (elapsed_.elapsed() / 1000.0))) / MB_CONV;
-        ui_->bitrate->setText(QStringLiteral("Acquired: %1 MB @ %2 Mbps").arg(QString::number(total, 'f', 1)).arg(QString::number(br, 'f', 3)));
+        auto skipped = images_[0].dropped() + images_[1].dropped();
+        auto text = QStringLiteral("Acquired: %1 MB @ %2 Mbps, Skipped: %3 Frames").arg(QString::number(total, 'f', 1)).arg(QString::number(br, 'f', 3)).arg(skipped);
+        CusMetrics metrics;
+        if (solumGetMetrics(&metrics) == 0)
+        {
+            const auto& st = metrics.streams[StreamProcessed];
+            text += QStringLiteral(", Lost: %1 Packets, Latency: %2 ms").arg(st.packetsLost).arg(QString::number(st.endToEnd.mean / 1000.0, 'f', 1));
+        }
+        ui_->bitrate->setText(text);
     });
 
     // connect ble device list
@@ -255,6 +263,11 @@ void Solum::closeEvent(QCloseEvent*)
     if (connected_)
         solumDisconnect();
 
+    // a frame callback may still be in flight, wait for it to finish with the mailboxes before releasing their leases
+    closing_ = true;
+    while (publishing_)
+        std::this_thread::yield();
+    releaseImages();
     solumDestroy();
 }
 
@@ -370,8 +383,7 @@ bool Solum::event(QEvent *event)
     }
     else if (event->type() == IMAGE_EVENT)
     {
-        auto evt = static_cast<event::Image*>(event);
-        newProcessedImage(evt->data_, evt->width_, evt->height_, evt->bpp_, evt->format_, evt->size_, evt->overlay_, evt->imu_);
+        showLatestImages();
         return true;
     }
     else if (event->type() == PRESCAN_EVENT)
@@ -389,7 +401,7 @@ bool Solum::event(QEvent *event)
     else if (event->type() == RF_EVENT)
     {
         auto evt = static_cast<event::RfImage*>(event);
-        newRfImage(evt->data_, evt->width_, evt->height_, evt->bpp_ / 8);
+        newRfImage(evt->data_, evt->width_, evt->height_, evt->bpp_ / 8, evt->axial_);
         return true;
     }
     else if (event->type() == IMAGING_EVENT)
@@ -457,6 +469,12 @@ bool Solum::event(QEvent *event)
         onElementTestResult(evt->res_, evt->val_);
         return true;
     }
+    else if (event->type() == GEOMETRY_EVENT)
+    {
+        // while frozen no new frames arrive to carry the geometry, so apply it right away
+        image_->applyGeometry(static_cast<event::Geometry*>(event)->geometry_, !imaging_);
+        return true;
+    }
 
     return QMainWindow::event(event);
 }
@@ -595,6 +613,7 @@ void Solum::imagingState(CusImagingState state, bool imaging)
             else
             {
                 brTimer_.stop();
+                image_->flushGeometry();
             }
         }
 
@@ -679,50 +698,73 @@ void Solum::onRawReadyToDownload(int sz, const QString& ext)
     {
         ui_->status->showMessage(QStringLiteral("Raw Package Size: %1 MB").arg(QString::number(static_cast<double>(sz) / MB_CONV, 'f', 2)));
         rawData_.size_ = sz;
-        rawData_.file_ = QFileDialog::getSaveFileName(this, QStringLiteral("Save Raw Data"), QDir::homePath() + QLatin1Char('/') + QStringLiteral("raw_data%1").arg(ext), QStringLiteral("(*%1)").arg(ext));
-        if (rawData_.file_.isEmpty())
+        auto file = QFileDialog::getSaveFileName(this, QStringLiteral("Save Raw Data"), QDir::homePath() + QLatin1Char('/') + QStringLiteral("raw_data%1").arg(ext), QStringLiteral("(*%1)").arg(ext));
+        if (file.isEmpty())
             return;
 
-        setProgress(RAW_PROGRESS, 0);
-
-        rawData_.data_.resize(rawData_.size_);
-        rawData_.ptr_ = rawData_.data_.data();
+        rawData_.file_.setFileName(file);
+        if (!rawData_.file_.open(QIODevice::WriteOnly))
+        {
+            ui_->status->showMessage(QStringLiteral("Error Opening Requested File"));
+            return;
+        }
 
-        if (solumReadRawData((void**)(&rawData_.ptr_),
-            [](int res)
-            {
-                // call is complete, post event to manage actual storage
-                QApplication::postEvent(_me, new event::RawDownloaded(res));
-            },
-            [](int progress)
-            {
-                QApplication::postEvent(_me, new event::Progress(RAW_PROGRESS, progress));
-            }
-            ) < 0)
-                ui_->status->showMessage(QStringLiteral("Raw Download Failed"));
+        setProgress(RAW_PROGRESS, 0);
+        rawData_.attempts_ = 0;
+        if (!readRawData(0))
+        {
+            rawData_.file_.remove();
+            ui_->status->showMessage(QStringLiteral("Raw Download Failed"));
+        }
     }
     else
         ui_->status->showMessage(QStringLiteral("Error Packaging Raw Data"));
 }
 
+/// streams the package straight into the file rather than holding it in memory
+/// @param[in] offset offset within the package to start from, i.e. the number of bytes already written
+/// @return success of the call
+bool Solum::readRawData(long long int offset)
+{
+    return (solumReadRawDataResume(offset, 0, RAW_RETRIES,
+        [](const void* data, int size, long long int pos, void* user) -> int
+        {
+            auto& f = static_cast<Solum*>(user)->rawData_.file_;
+            if (f.pos() != pos && !f.seek(pos))
+                return -1;
+            return (f.write(static_cast<const char*>(data), size) == size) ? 0 : -1;
+        },
+        [](int res, void* user)
+        {
+            // call is complete, post event to finish up the file
+            QApplication::postEvent(static_cast<Solum*>(user), new event::RawDownloaded(res));
+        },
+        [](int progress, void* user)
+        {
+            QApplication::postEvent(static_cast<Solum*>(user), new event::Progress(RAW_PROGRESS, progress));
+        },
+        this) == 0);
+}
+
 /// called when the download has completed or failed
 /// @param[in] res the download result
 void Solum::onRawDownloaded(int res)
 {
     if (res <= 0)
     {
+        // chunks are verified before they are written, thus the download picks up after the data already in the file
+        const auto written = rawData_.file_.pos();
+        if (rawData_.attempts_++ < RAW_RESUMES && readRawData(written))
+        {
+            ui_->status->showMessage(QStringLiteral("Resuming Raw Download at %1 MB").arg(QString::number(static_cast<double>(written) / MB_CONV, 'f', 2)));
+            return;
+        }
+        rawData_.file_.remove();
         ui_->status->showMessage(QStringLiteral("Raw Download Failed"));
     }
     else
     {
-        QFile f(rawData_.file_);
-        if (!f.open(QIODevice::WriteOnly))
-        {
-                ui_->status->showMessage(QStringLiteral("Error Opening Requested File"));
-            return;
-        }
-        f.write(rawData_.data_);
-        f.close();
+        rawData_.file_.close();
         ui_->status->showMessage(QStringLiteral("Successfully Downloaded Data"));
     }
 }
@@ -745,6 +787,97 @@ void Solum::onFormat(int format)
     solumSetFormat(static_cast<CusImageFormat>(format));
 }
 
+/// publishes a new processed image for display, called from the api callback thread
+/// @param[in] frame the leased frame holding the image data
+/// @param[in] nfo the image information
+/// @param[in] imu the imu data if valid
+void Solum::publishImage(CusFrame* frame, const CusProcessedImageInfo* nfo, const QQuaternion& imu)
+{
+    // announce the publisher before checking the flag, such that closing either sees it or it sees closing
+    publishing_++;
+    if (closing_)
+    {
+        publishing_--;
+        return;
+    }
+
+    const int index = nfo->overlay ? 1 : 0;
+    const bool delta = (nfo->format == Delta8Bit);
+    auto& decoder = delta_[index];
+    // delta frames depend on the previous one, so every frame is decoded as it arrives and only decoded images may be
+    // skipped. after a failure the frames are dropped until the next keyframe
+    if (delta)
+    {
+        if (decoder.decode(solumFrameData(frame), static_cast<size_t>(nfo->imageSize)) != 0 || decoder.width() != nfo->width || decoder.height() != nfo->height)
+        {
+            publishing_--;
+            return;
+        }
+    }
+    // otherwise hold a lease on the frame until it has been displayed or replaced, which avoids a deep copy of the image data
+    else if (solumFrameAcquire(frame) != CUS_SUCCESS)
+    {
+        publishing_--;
+        return;
+    }
+
+    auto& mailbox = images_[index];
+    auto& slot = mailbox.back();
+    // the recycled slot holds either a frame that was already displayed or one that got skipped
+    if (slot.frame_)
+        solumFrameRelease(slot.frame_);
+    slot.frame_ = delta ? nullptr : frame;
+    slot.decoded_.clear();
+    if (delta)
+        slot.decoded_.assign(decoder.image(), decoder.image() + static_cast<size_t>(nfo->width) * static_cast<size_t>(nfo->height));
+    slot.width_ = nfo->width;
+    slot.height_ = nfo->height;
+    slot.bpp_ = delta ? 8 : nfo->bitsPerPixel;
+    slot.format_ = delta ? Uncompressed8Bit : nfo->format;
+    slot.size_ = delta ? static_cast<int>(slot.decoded_.size()) : nfo->imageSize;
+    slot.overlay_ = nfo->overlay ? true : false;
+    slot.imu_ = imu;
+    slot.generation_ = nfo->generation;
+    mailbox.publish();
+    publishing_--;
+
+    // only post if the gui has caught up, otherwise the pending event will pick up the latest image
+    if (!imagePending_.exchange(true))
+        QApplication::postEvent(this, new QEvent(IMAGE_EVENT));
+}
+
+/// displays the latest published images, skipping any that were replaced in the meantime
+void Solum::showLatestImages()
+{
+    // clear the flag prior to fetching, so that an image published from here on posts a new event
+    imagePending_ = false;
+    for (auto& mailbox : images_)
+    {
+        if (!mailbox.update())
+            continue;
+        const auto& img = mailbox.front();
+        const void* data = img.frame_ ? solumFrameData(img.frame_) : (img.decoded_.empty() ? nullptr : img.decoded_.data());
+        if (data)
+            newProcessedImage(data, img.width_, img.height_, img.bpp_, img.format_, img.size_, img.overlay_, img.imu_, img.generation_);
+    }
+}
+
+/// releases the frame leases held by the image mailboxes
+/// @note must only be called once images are no longer being published
+void Solum::releaseImages()
+{
+    for (auto& mailbox : images_)
+    {
+        for (auto i = 0; i < 3; i++)
+        {
+            auto& img = mailbox.slot(i);
+            if (img.frame_)
+                solumFrameRelease(img.frame_);
+            img.frame_ = nullptr;
+        }
+    }
+}
+
 /// called when a new image has been sent
 /// @param[in] img the image data
 /// @param[in] w width of the image
@@ -753,14 +886,15 @@ void Solum::onFormat(int format)
 /// @param[in] format the image format
 /// @param[in] sz size of the image in bytes
 /// @param[in] imu the imu data if valid
-void Solum::newProcessedImage(const void* img, int w, int h, int bpp, CusImageFormat format, int sz, bool overlay, const QQuaternion& imu)
+/// @param[in] generation the generation of the geometry the image was produced with
+void Solum::newProcessedImage(const void* img, int w, int h, int bpp, CusImageFormat format, int sz, bool overlay, const QQuaternion& imu, long long int generation)
 {
     acquired_ += static_cast<uint64_t>(sz);
 
     if (overlay)
-        image2_->loadImage(img, w, h, bpp, format, sz);
+        image2_->loadImage(img, w, h, bpp, format, sz, generation);
     else
-        image_->loadImage(img, w, h, bpp, format, sz);
+        image_->loadImage(img, w, h, bpp, format, sz, generation);
 
     if (!imu.isNull())
         render_->update(imu);
@@ -804,9 +938,10 @@ void Solum::newSpectrumImage(const void* img, int l, int s, int bps)
 /// @param[in] l # of rf lines
 /// @param[in] s # of rf samples per line
 /// @param[in] ss sample size (should always be 2)
-void Solum::newRfImage(const void* rf, int l, int s, int ss)
+/// @param[in] axial axial microns per sample
+void Solum::newRfImage(const void* rf, int l, int s, int ss, double axial)
 {
-    signal_->loadSignal(rf, l, s, ss);
+    signal_->loadSignal(rf, l, s, ss, axial);
 }
 
 /// called when the connect/disconnect button is clicked
@@ -866,15 +1001,15 @@ void Solum::onUpdate()
     if (solumSoftwareUpdate(
         filePath.toStdString().c_str(),
         // software update result
-        [](CusSwUpdate res)
+        [](CusSwUpdate res, void* user)
         {
-            QApplication::postEvent(_me, new event::SwUpdate(res));
+            QApplication::postEvent(static_cast<Solum*>(user), new event::SwUpdate(res));
         },
         // download progress
-        [](int progress)
+        [](int progress, void* user)
         {
-            QApplication::postEvent(_me, new event::Progress(UPDATE_PROGRESS, progress));
-        }, 0) < 0)
+            QApplication::postEvent(static_cast<Solum*>(user), new event::Progress(UPDATE_PROGRESS, progress));
+        }, 0, this) < 0)
         ui_->status->showMessage(QStringLiteral("Error requesting software update"));
 }
 
@@ -897,10 +1032,10 @@ void Solum::onUpdateCert()
 
 void Solum::onBatteryHealth()
 {
-    solumBatteryHealth([](CusBatteryHealth res, double val)
+    solumBatteryHealth([](CusBatteryHealth res, double val, void* user)
     {
-        QApplication::postEvent(_me, new event::BatteryHealth(res, val));
-    });
+        QApplication::postEvent(static_cast<Solum*>(user), new event::BatteryHealth(res, val));
+    }, this);
 }
 
 /// initiates a workflow load
@@ -919,10 +1054,10 @@ void Solum::onProbeSelected(const QString &probe)
 {
     if (!probe.isEmpty())
     {
-        solumApplications(probe.toStdString().c_str(), [](const char* list, int)
+        solumApplications(probe.toStdString().c_str(), [](const char* list, int, void* user)
         {
-            QApplication::postEvent(_me, new event::List(list, false));
-        });
+            QApplication::postEvent(static_cast<Solum*>(user), new event::List(list, false));
+        }, this);
         settings_->setValue("probe", probe);
     }
 }
@@ -1023,19 +1158,21 @@ void Solum::onRawBuffer(int state)
 /// checks raw data availability
 void Solum::onRawAvailability()
 {
-    solumRawDataAvailability([](int res, int n_b, const long long*, int n_iqrf, const long long*)
+    solumRawDataAvailability([](int res, int n_b, const long long*, int n_iqrf, const long long*, void* user)
     {
-        QApplication::postEvent(_me, new event::RawAvailability(res, n_b, n_iqrf));
-    });
+        QApplication::postEvent(static_cast<Solum*>(user), new event::RawAvailability(res, n_b, n_iqrf));
+    }, this);
 }
 
 /// tries to download raw data
 void Solum::onRawDownload()
 {
-    solumRequestRawData(0, 0, 1, [](int sz, const char* extension)
+    // request everything in the buffer, narrow the selection down through the params to transfer less data
+    auto params = solumDefaultRawRequestParams();
+    solumRequestRawDataSelection(&params, [](int sz, const char* extension, void* user)
     {
-        QApplication::postEvent(_me, new event::RawReady(sz, QString::fromLatin1(extension)));
-    });
+        QApplication::postEvent(static_cast<Solum*>(user), new event::RawReady(sz, QString::fromLatin1(extension)));
+    }, this);
 }
 
 /// called when separate overlays is changed
@@ -1113,10 +1250,6 @@ void Solum::getParams()
         ui_->tgcmid->setValue(static_cast<int>(t.mid));
         ui_->tgcbottom->setValue(static_cast<int>(t.bottom));
     }
-
-    image_->checkActiveRegion();
-    image_->checkRoi();
-    image_->checkGate();
 }
 
 /// called on a mode change
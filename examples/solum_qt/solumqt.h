@@ -2,6 +2,8 @@
 
 #include "ble.h"
 #include <solum/solum_def.h>
+#include <solum/solum_delta.h>
+#include <solum/solum_mailbox.h>
 
 namespace Ui
 {
@@ -35,6 +37,7 @@ class ProbeRender;
 #define IMU_PORT_EVENT          static_cast<QEvent::Type>(QEvent::User + 19)
 #define BATTERY_HEALTH_EVENT    static_cast<QEvent::Type>(QEvent::User + 20)
 #define ELEMENT_TEST_EVENT      static_cast<QEvent::Type>(QEvent::User + 21)
+#define GEOMETRY_EVENT          static_cast<QEvent::Type>(QEvent::User + 22)
 
 namespace event
 {
@@ -236,6 +239,17 @@ namespace event
         QQuaternion imu_;   ///< latest imu position
     };
 
+    /// wrapper for geometry events that can be posted from the api callbacks
+    class Geometry : public QEvent
+    {
+    public:
+        /// default constructor
+        /// @param[in] geometry the new geometry
+        explicit Geometry(const CusGeometry& geometry) : QEvent(GEOMETRY_EVENT), geometry_(geometry) { }
+
+        CusGeometry geometry_;  ///< the new geometry
+    };
+
 
     /// wrapper for error events that can be posted from the api callbacks
     class Error : public QEvent
@@ -332,12 +346,29 @@ namespace event
 class RawData
 {
 public:
-    RawData() : size_(0), ptr_(nullptr) { }
+    RawData() : size_(0), attempts_(0) { }
 
-    QString file_;
-    int size_;
-    QByteArray data_;
-    char* ptr_;
+    QFile file_;    ///< file the package is streamed into, written from the download thread
+    int size_;      ///< size of the package
+    int attempts_;  ///< number of times the download was resumed
+};
+
+/// processed image held through a frame lease
+class LeasedImage
+{
+public:
+    LeasedImage() : frame_(nullptr), width_(0), height_(0), bpp_(0), format_(Uncompressed), size_(0), overlay_(false), generation_(0) { }
+
+    CusFrame* frame_;       ///< the leased frame, null if empty
+    int width_;             ///< width of the image
+    int height_;            ///< height of the image
+    int bpp_;               ///< bits per pixel
+    CusImageFormat format_; ///< image format
+    int size_;              ///< total size of image
+    bool overlay_;          ///< flag if the image came from a separated overlay
+    QQuaternion imu_;       ///< latest imu position
+    long long int generation_; ///< generation of the geometry the image was produced with
+    std::vector<uint8_t> decoded_; ///< decoded delta frame, shown in place of a leased frame
 };
 
 using Probes = std::map<QString,QString>;
@@ -351,6 +382,8 @@ public:
     explicit Solum(QWidget *parent = nullptr);
     ~Solum() override;
 
+    void publishImage(CusFrame* frame, const CusProcessedImageInfo* nfo, const QQuaternion& imu);
+
 protected:
     virtual bool event(QEvent *event) override;
     virtual void closeEvent(QCloseEvent *event) override;
@@ -358,10 +391,12 @@ protected:
 private:
     void loadProbes(const QStringList& probes);
     void loadApplications(const QStringList& probes);
-    void newProcessedImage(const void* img, int w, int h, int bpp, CusImageFormat format, int sz, bool overlay, const QQuaternion& imu);
+    void showLatestImages();
+    void releaseImages();
+    void newProcessedImage(const void* img, int w, int h, int bpp, CusImageFormat format, int sz, bool overlay, const QQuaternion& imu, long long int generation);
     void newPrescanImage(const void* img, int w, int h, int bpp, int sz, CusImageFormat format);
     void newSpectrumImage(const void* img, int l, int s, int bps);
-    void newRfImage(const void* rf, int l, int s, int ss);
+    void newRfImage(const void* rf, int l, int s, int ss, double axial);
     void newImuData(const QQuaternion& imu);
     void setConnected(CusConnection res, int port, const QString& msg);
     void certification(int daysValid);
@@ -373,6 +408,7 @@ private:
     void onRawAvailabilityResult(int res, int b, int iqrf);
     void onRawReadyToDownload(int sz, const QString& ext);
     void onRawDownloaded(int res);
+    bool readRawData(long long int offset);
     void onBatteryHealthResult(CusBatteryHealth res, double val);
     void onElementTestResult(CusElementTest res, double val);
     void setProgress(int selection, int progress);
@@ -444,4 +480,9 @@ private:
     RawData rawData_;               ///< holds raw data info
     CusAcoustic acoustic_;          ///< holds latest acoustic data
     std::unique_ptr<QSettings> settings_;   ///< persistent settings
+    solum::Mailbox<LeasedImage> images_[2]; ///< latest grayscale and overlay images
+    std::atomic_bool imagePending_;         ///< flag if an image event is waiting to be processed
+    std::atomic_bool closing_;              ///< set when closing, after which no more images are published
+    std::atomic_int publishing_;            ///< number of callbacks currently publishing an image
+    solum::DeltaDecoder delta_[2];          ///< decoders for delta frames of the grayscale and overlay images
 };
@@ -36,6 +36,11 @@ typedef struct _CusInitParams
     CusNewImuDataFn newImuDataFn;               ///< new imu data callback
     int width;                                  ///< the width of the output buffer
     int height;                                 ///< the height of the output buffer
+    CusNewFrameFn newFrameFn;                   ///< new leased processed image callback (zero-copy alternative to newProcessedImageFn)
+    int framePoolDepth;                         ///< the number of buffers in the pool backing leased frames, 0 for the library default
+    CusIngestParams ingest;                     ///< udp image stream ingest settings
+    void* userData;                             ///< user data passed through to every callback of these parameters, as well as the tee callback
+    CusGeometryFn geometryFn;                   ///< geometry change callback, made whenever the active region, roi or gate changes
 
 } CusInitParams;
 
@@ -52,9 +57,23 @@ extern "C" {
     SOLUM_EXPORT int solumInit(const CusInitParams* params);
 
     /// get init params with default values
-    /// @return a zero initialized struct
+    /// @return a zero initialized struct, apart from the ingest cpu affinity which is set to -1
     SOLUM_EXPORT CusInitParams solumDefaultInitParams(void);
 
+    /// get sdk configuration with default values
+    /// @return a struct with logging and tracing disabled
+    SOLUM_EXPORT CusConfig solumDefaultConfig(void);
+
+    /// applies the sdk configuration, which is shared by every context in the process
+    /// @param[in] config the configuration
+    /// @return success of the call
+    /// @retval 0 the configuration was applied
+    /// @retval -1 the configuration could not be applied, or the trace file could not be created
+    /// @note may be called before solumInit(). while tracing, spans are recorded for packet receive, frame reassembly,
+    ///       image encoding and decoding, reconstruction and each callback invocation, tagged with the thread id and the
+    ///       frame timestamp (tm). the trace file is completed when tracing is disabled or the module is destroyed
+    SOLUM_EXPORT int solumSetConfig(const CusConfig* config);
+
     /// cleans up memory allocated by the solum module
     /// @retval 0 the destroy attempt was successful
     /// @retval -1 the destroy attempt was not successful
@@ -116,25 +135,28 @@ extern "C" {
     /// @param[in] progress software update progress callback
     /// @param[in] hwVer optional hardware version to set if the library cannot determine version on initial tcp connection
     ///                  set to 0, unless there is a reason to force the version (1, 2, or 3)
+    /// @param[in] user user data passed through to the callbacks
     /// @return success of the call
     /// @retval 0 the software is being sent
     /// @retval -1 the software could not be sent
-    SOLUM_EXPORT int solumSoftwareUpdate(const char* path, CusSwUpdateFn fn, CusProgressFn progress, int hwVer);
+    SOLUM_EXPORT int solumSoftwareUpdate(const char* path, CusSwUpdateFn fn, CusProgressFn progress, int hwVer, void* user);
 
     /// retrieves the available probe models the api supports
     /// @param[in] fn the callback function that reports the list
+    /// @param[in] user user data passed through to the callbacks
     /// @return success of the call
     /// @retval 0 the information was retrieved
     /// @retval -1 the information could not be retrieved
-    SOLUM_EXPORT int solumProbes(CusListFn fn);
+    SOLUM_EXPORT int solumProbes(CusListFn fn, void* user);
 
     /// retrieves the available applications for a specific probe model
     /// @param[in] probe the probe model to retrieve applications for
     /// @param[in] fn the callback function that reports the list
+    /// @param[in] user user data passed through to the callbacks
     /// @return success of the call
     /// @retval 0 the information was retrieved
     /// @retval -1 the information could not be retrieved
-    SOLUM_EXPORT int solumApplications(const char* probe, CusListFn fn);
+    SOLUM_EXPORT int solumApplications(const char* probe, CusListFn fn, void* user);
 
     /// loads an application
     /// @param[in] probe the probe model to load
@@ -168,6 +190,30 @@ extern "C" {
     ///       the frame will have various sizes of black borders around the image
     SOLUM_EXPORT int solumSetOutputSize(int w, int h);
 
+    /// requests new dimensions of the output display for scan conversion without interrupting imaging
+    /// @param[in] w the number of pixels in the horizontal direction
+    /// @param[in] h the number of pixels in the vertical direction
+    /// @param[in] fn callback made once the new size is live, holding the resulting geometry, may be null
+    /// @param[in] user user data passed to the callback
+    /// @return success of the call
+    /// @retval 0 the request was made
+    /// @retval -1 the request could not be made
+    /// @note frames keep being produced at the previous size until the pipeline is reconfigured. requests are coalesced,
+    ///       a request made while another is pending replaces it, and only the latest callback is made. the geometry callback
+    ///       provided through CusInitParams is made as well
+    /// @note the callback is made from a library thread at some later point, the user data must remain valid until then
+    SOLUM_EXPORT int solumRequestOutputSize(int w, int h, CusGeometryFn fn, void* user);
+
+    /// sets several output targets for scan conversion, all produced from a single reconstruction of each frame
+    /// @param[in] sizes the dimensions of each target, the first being the target also set through solumSetOutputSize()
+    /// @param[in] count the number of targets (1 - CUS_MAXOUTPUT)
+    /// @return success of the call
+    /// @retval 0 the output sizes were successfully programmed
+    /// @retval -1 the output sizes could not be set
+    /// @note the processed image callback is called once per target for each frame, one after the other in target order,
+    ///       with CusProcessedImageInfo::output holding the index of the target
+    SOLUM_EXPORT int solumSetOutputSizes(const CusOutputSize* sizes, int count);
+
     /// sets a flag to separate overlays into separate images, for example if color/power Doppler or strain
     /// imaging is enabled, two callbacks will be generated, one with the grayscale frame, and the other with the overlay
     /// @param[in] en the enable flag for separating overlays
@@ -312,6 +358,84 @@ extern "C" {
     /// @retval -1 the format could not be set
     SOLUM_EXPORT int solumSetFormat(CusImageFormat format);
 
+    /// acquires a lease on a frame so that it remains valid after the callback returns
+    /// @param[in] frame the frame handle passed to the callback
+    /// @return success of the call
+    /// @retval 0 the lease was acquired
+    /// @retval -1 the lease could not be acquired
+    /// @note every successful acquire must be matched with a call to solumFrameRelease, when all buffers of the pool are held
+    ///       by the application, new frames are dropped until a lease is released, see CusInitParams::framePoolDepth
+    SOLUM_EXPORT int solumFrameAcquire(CusFrame* frame);
+
+    /// releases a lease on a frame, returning the buffer to the frame pool once no leases remain
+    /// @param[in] frame the frame handle to release
+    /// @return success of the call
+    /// @retval 0 the lease was released
+    /// @retval -1 the lease could not be released
+    /// @note can be called from any thread
+    SOLUM_EXPORT int solumFrameRelease(CusFrame* frame);
+
+    /// retrieves the image data of a leased frame
+    /// @param[in] frame the frame handle
+    /// @return pointer to the image data, null if the handle is invalid
+    SOLUM_EXPORT const void* solumFrameData(const CusFrame* frame);
+
+    /// retrieves the size of the image data of a leased frame
+    /// @param[in] frame the frame handle
+    /// @return size of the image data in bytes
+    /// @retval -1 the handle is invalid
+    SOLUM_EXPORT int solumFrameSize(const CusFrame* frame);
+
+    /// retrieves the positional information tagged with a leased frame
+    /// @param[in] frame the frame handle
+    /// @param[out] pos holds a pointer to the positional information, valid for as long as the frame is leased
+    /// @return the number of positional information data tagged with the frame
+    /// @retval -1 the handle is invalid
+    SOLUM_EXPORT int solumFramePositions(const CusFrame* frame, const CusPosInfo** pos);
+
+    /// enables or disables the frame queue for a stream, allowing frames to be pulled with solumDequeueFrame
+    /// @param[in] stream the stream to queue frames for
+    /// @param[in] depth the maximum number of frames held by the queue, 0 to disable the queue
+    /// @param[in] policy the policy applied when a frame arrives while the queue is full
+    /// @return success of the call
+    /// @retval 0 the queue was configured
+    /// @retval -1 the queue could not be configured
+    /// @note queued frames are delivered in addition to the stream's callback, leave the callback unset to only pull frames,
+    ///       each queued frame holds a lease, thus the frame pool depth should be larger than the combined queue depths
+    SOLUM_EXPORT int solumSetFrameQueue(CusStream stream, int depth, CusQueueOverflow policy);
+
+    /// pulls the oldest frame from a stream's frame queue
+    /// @param[in] stream the stream to pull from
+    /// @param[in] timeoutMs the time to wait for a frame in milliseconds, 0 to return immediately, -1 to wait indefinitely
+    /// @param[out] frame holds the frame and its information, the frame must be released with solumFrameRelease
+    /// @return success of the call
+    /// @retval 0 a frame was dequeued
+    /// @retval 1 no frame arrived before the timeout expired
+    /// @retval -1 the queue is not enabled or was disabled while waiting
+    /// @note can be called from multiple consumer threads concurrently
+    SOLUM_EXPORT int solumDequeueFrame(CusStream stream, int timeoutMs, CusQueuedFrame* frame);
+
+    /// retrieves the statistics of a stream's frame queue
+    /// @param[in] stream the stream to retrieve the statistics for
+    /// @param[out] stats holds the queue statistics
+    /// @return success of the call
+    /// @retval 0 the statistics were retrieved
+    /// @retval -1 the statistics could not be retrieved
+    SOLUM_EXPORT int solumFrameQueueStats(CusStream stream, CusQueueStats* stats);
+
+    /// retrieves the pipeline metrics accumulated since initialization or the last reset
+    /// @param[out] metrics holds the metrics
+    /// @return success of the call
+    /// @retval 0 the metrics were retrieved
+    /// @retval -1 the metrics could not be retrieved
+    SOLUM_EXPORT int solumGetMetrics(CusMetrics* metrics);
+
+    /// resets all pipeline metrics
+    /// @return success of the call
+    /// @retval 0 the metrics were reset
+    /// @retval -1 the metrics could not be reset
+    SOLUM_EXPORT int solumResetMetrics(void);
+
     /// will try and optimize the wireless channel when the probe is running its own network
     /// the function will return a failure if the probe is on an external wlan as nothing can be optimized, except for switching over to the probe's own network
     /// to switch to the probe's network, see the bluetooth documentation for the wireless management service
@@ -332,33 +456,83 @@ extern "C" {
 
     /// makes a request to return the availability of all the raw data currently buffered on the probe
     /// @param[in] fn result callback function that will return all the timestamps of the data blocks that are buffered
+    /// @param[in] user user data passed through to the callbacks
     /// @return success of the call
     /// @retval 0 the request was successfully made
     /// @retval -1 the request could not be made
     /// @note the probe must be frozen with raw data buffering enabled prior to calling the function
-    SOLUM_EXPORT int solumRawDataAvailability(CusRawAvailabilityFn fn);
+    SOLUM_EXPORT int solumRawDataAvailability(CusRawAvailabilityFn fn, void* user);
 
     /// makes a request for raw data from the probe
     /// @param[in] start the first frame to request, as determined by timestamp in nanoseconds, set to 0 along with end to requests all data in buffer
     /// @param[in] end the last frame to request, as determined by timestamp in nanoseconds, set to 0 along with start to requests all data in buffer
     /// @param[in] lzo flag to specify a tarball with lzo compressed raw data inside (default) vs no compression of raw data
     /// @param[in] fn result callback function, will return size of buffer required upon success, 0 if no raw data was buffered, or -1 if request could not be made
+    /// @param[in] user user data passed through to the callbacks
     /// @return success of the call
     /// @retval 0 the request was successfully made
     /// @retval -1 the request could not be made
     /// @note the probe must be frozen and in a raw data buffering mode in order for the call to succeed
-    SOLUM_EXPORT int solumRequestRawData(long long int start, long long int end, int lzo, CusRawRequestFn fn);
+    SOLUM_EXPORT int solumRequestRawData(long long int start, long long int end, int lzo, CusRawRequestFn fn, void* user);
+
+    /// get raw data request params with default values
+    /// @return a struct requesting all lzo compressed data in the buffer
+    SOLUM_EXPORT CusRawRequestParams solumDefaultRawRequestParams(void);
+
+    /// makes a request for a selection of the raw data from the probe, such that only the streams, frames, lines and samples of
+    /// interest are packaged and transferred
+    /// @param[in] params the request parameters
+    /// @param[in] fn result callback function, will return size of buffer required upon success, 0 if no raw data matched the selection, or -1 if request could not be made
+    /// @param[in] user user data passed through to the callbacks
+    /// @return success of the call
+    /// @retval 0 the request was successfully made
+    /// @retval -1 the request could not be made, i.e. the line or sample window lies outside of the buffered data
+    /// @note the probe must be frozen and in a raw data buffering mode in order for the call to succeed
+    /// @note the package is retrieved through solumReadRawData or solumReadRawDataStream, its raw files describing the selected lines and samples
+    SOLUM_EXPORT int solumRequestRawDataSelection(const CusRawRequestParams* params, CusRawRequestFn fn, void* user);
 
     /// retrieves raw data from a previous request
     /// @param[out] data a pointer to a buffer that has been allocated to read the raw data into, this must be pre-allocated with
     ///             the size returned from a previous call to solumRequestRawData
     /// @param[in] fn result callback function, will return size of buffer required upon success, 0 if no raw data was buffered, or -1 if request could not be made,
     /// @param[in] progress download progress callback function that outputs the progress in percent
+    /// @param[in] user user data passed through to the callbacks
+    /// @return success of the call
+    /// @retval 0 the read request was successfully made
+    /// @retval -1 the read request could not be made
+    /// @note the probe must be frozen and a successful call to solumRequestRawData must have taken place in order for the call to succeed
+    SOLUM_EXPORT int solumReadRawData(void** data, CusRawFn fn, CusProgressFn progress, void* user);
+
+    /// retrieves raw data from a previous request in chunks, such that packages of any size download with a fixed size buffer
+    /// @param[in] chunkSize size of the chunks in bytes, 0 for the default of 1 MB
+    /// @param[in] sink chunk callback function, called for each chunk in the order of the package, aborting the download when it fails
+    /// @param[in] fn result callback function, will return the size of the package upon success, or -1 if the download failed or was aborted
+    /// @param[in] progress download progress callback function that outputs the progress in percent
+    /// @param[in] user user data passed through to the callbacks
     /// @return success of the call
     /// @retval 0 the read request was successfully made
     /// @retval -1 the read request could not be made
+    /// @note the sink is called on the download thread while the next chunk is received, such that network and disk transfers overlap
+    ///       as long as the sink keeps up, a slower sink throttles the download rather than buffering more data
     /// @note the probe must be frozen and a successful call to solumRequestRawData must have taken place in order for the call to succeed
-    SOLUM_EXPORT int solumReadRawData(void** data, CusRawFn fn, CusProgressFn progress);
+    SOLUM_EXPORT int solumReadRawDataStream(int chunkSize, CusRawChunkFn sink, CusRawFn fn, CusProgressFn progress, void* user);
+
+    /// resumes retrieving raw data from a previous request in chunks, skipping the part of the package already received
+    /// @param[in] offset offset within the package to resume from in bytes, i.e. the number of bytes the sink stored before the download failed
+    /// @param[in] chunkSize size of the chunks in bytes, 0 for the default of 1 MB
+    /// @param[in] retries number of times a chunk that fails its checksum or times out is requested again before the download fails
+    /// @param[in] sink chunk callback function, called for each chunk in the order of the package, aborting the download when it fails
+    /// @param[in] fn result callback function, will return the size of the package upon success, or -1 if the download failed or was aborted
+    /// @param[in] progress download progress callback function that outputs the progress in percent of the whole package, including the bytes skipped
+    /// @param[in] user user data passed through to the callbacks
+    /// @return success of the call
+    /// @retval 0 the read request was successfully made
+    /// @retval -1 the read request could not be made, i.e. the offset lies beyond the package
+    /// @note every chunk is checked against a crc32 calculated by the probe and only passed to the sink once verified, thus all data a sink stored
+    ///       before a failure is intact and the download can resume from the number of bytes stored, solumReadRawDataStream behaves the same
+    ///       starting from the beginning of the package
+    /// @note the probe must remain frozen since the request, as a new request or imaging discards the package
+    SOLUM_EXPORT int solumReadRawDataResume(long long int offset, int chunkSize, int retries, CusRawChunkFn sink, CusRawFn fn, CusProgressFn progress, void* user);
 
     /// sets a low level parameter to a specific value to gain access to lower level device control
     /// @param[in] prm the parameter to change
@@ -416,20 +590,22 @@ extern "C" {
     /// @param[in] stationary set to 1 if calibrating for stationary detection, 0 for motion calibration
     /// @param[in] fn the callback upon calibration completion
     /// @param[in] progress the callback for calibration completion rate
+    /// @param[in] user user data passed through to the callbacks
     /// @return success of the call
     /// @note the probe must be frozen to calibrate the imu
     /// @retval 0 the call was successful
     /// @retval -1 the call was not successful
-    SOLUM_EXPORT int solumCalibrateImu(int stationary, CusImuCalibrationFn fn, CusProgressFn progress);
+    SOLUM_EXPORT int solumCalibrateImu(int stationary, CusImuCalibrationFn fn, CusProgressFn progress, void* user);
 
     /// runs a battery health test
     /// @param[in] fn the callback upon test completion
+    /// @param[in] user user data passed through to the callbacks
     /// @return success of the call
     /// @note the probe must be frozen to run the battery health test
     ///       this check may take up to 10 seconds to return a result
     /// @retval 0 the call was successful
     /// @retval -1 the call was not successful
-    SOLUM_EXPORT int solumBatteryHealth(CusBatteryHealthFn fn);
+    SOLUM_EXPORT int solumBatteryHealth(CusBatteryHealthFn fn, void* user);
 
 #ifdef __cplusplus
 }
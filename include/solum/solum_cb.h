@@ -6,38 +6,53 @@
 /// string list callback function
 /// @param[in] list the string list
 /// @param[in] sz the size of the string buffer
-typedef void (*CusListFn)(const char* list, int sz);
+/// @param[in] user the user data provided along with the callback
+typedef void (*CusListFn)(const char* list, int sz, void* user);
 /// connection callback function
 /// @param[in] res the connection result
 /// @param[in] port udp port used for streaming
 /// @param[in] status the status message
-typedef void (*CusConnectFn)(CusConnection res, int port, const char* status);
+/// @param[in] user the user data provided through CusInitParams::userData
+typedef void (*CusConnectFn)(CusConnection res, int port, const char* status, void* user);
 /// certification callback function
 /// @param[in] daysValid # of days valid for certificate
-typedef void (*CusCertFn)(int daysValid);
+/// @param[in] user the user data provided through CusInitParams::userData
+typedef void (*CusCertFn)(int daysValid, void* user);
 /// powering down callback function
 /// @param[in] res the power down reason
 /// @param[in] tm time in seconds for when probe is powering down, 0 for immediately
-typedef void (*CusPowerDownFn)(CusPowerDown res, int tm);
+/// @param[in] user the user data provided through CusInitParams::userData
+typedef void (*CusPowerDownFn)(CusPowerDown res, int tm, void* user);
 /// software update callback function
 /// @param[in] res the software update result
-typedef void (*CusSwUpdateFn)(CusSwUpdate res);
+/// @param[in] user the user data provided along with the callback
+typedef void (*CusSwUpdateFn)(CusSwUpdate res, void* user);
 /// new data callback function
 /// @param[in] img pointer to the new grayscale image information
 /// @param[in] nfo image information associated with the image data
 /// @param[in] npos number of positional information data tagged with the image
 /// @param[in] pos the positional information data tagged with the image
-typedef void (*CusNewRawImageFn)(const void* img, const CusRawImageInfo* nfo, int npos, const CusPosInfo* pos);
+/// @param[in] user the user data provided through CusInitParams::userData
+typedef void (*CusNewRawImageFn)(const void* img, const CusRawImageInfo* nfo, int npos, const CusPosInfo* pos, void* user);
 /// new image callback function
 /// @param[in] img pointer to the new grayscale image information
 /// @param[in] nfo image information associated with the image data
 /// @param[in] npos number of positional information data tagged with the image
 /// @param[in] pos the positional information data tagged with the image
-typedef void (*CusNewProcessedImageFn)(const void* img, const CusProcessedImageInfo* nfo, int npos, const CusPosInfo* pos);
+/// @param[in] user the user data provided through CusInitParams::userData
+typedef void (*CusNewProcessedImageFn)(const void* img, const CusProcessedImageInfo* nfo, int npos, const CusPosInfo* pos, void* user);
+/// new leased image callback function
+/// @param[in] frame handle to the leased frame, only valid until the callback returns unless acquired with solumFrameAcquire
+/// @param[in] nfo image information associated with the image data
+/// @param[in] npos number of positional information data tagged with the image
+/// @param[in] pos the positional information data tagged with the image
+/// @param[in] user the user data provided through CusInitParams::userData
+typedef void (*CusNewFrameFn)(CusFrame* frame, const CusProcessedImageInfo* nfo, int npos, const CusPosInfo* pos, void* user);
 /// new spectral image callback function
 /// @param[in] img pointer to the new grayscale image information
 /// @param[in] nfo image information associated with the image data
-typedef void (*CusNewSpectralImageFn)(const void* img, const CusSpectralImageInfo* nfo);
+/// @param[in] user the user data provided through CusInitParams::userData
+typedef void (*CusNewSpectralImageFn)(const void* img, const CusSpectralImageInfo* nfo, void* user);
 /// imaging callback function
 /// used primarily to denote 4 different scenarios:
 /// 1. when imaging is ready after an application load or parameter update (ImagingReady state)
@@ -46,32 +61,50 @@ typedef void (*CusNewSpectralImageFn)(const void* img, const CusSpectralImageInf
 /// 4. when the probe has frozen or unfrozen due to an internal state change (all other states)
 /// @param[in] state the imaging state
 /// @param[in] imaging 1 = running , 0 = stopped
-typedef void (*CusImagingFn)(CusImagingState state, int imaging);
+/// @param[in] user the user data provided through CusInitParams::userData
+typedef void (*CusImagingFn)(CusImagingState state, int imaging, void* user);
 /// button callback function
 /// @param[in] btn the button that was pressed
 /// @param[in] clicks # of clicks performed
-typedef void (*CusButtonFn)(CusButton btn, int clicks);
+/// @param[in] user the user data provided through CusInitParams::userData
+typedef void (*CusButtonFn)(CusButton btn, int clicks, void* user);
 /// progress callback function
 /// @param[in] progress the current progress in percent
-typedef void (*CusProgressFn)(int progress);
+/// @param[in] user the user data provided along with the callback
+typedef void (*CusProgressFn)(int progress, void* user);
 /// raw data availability callback function
 /// @param[in] res the request result: 0 on success, -1 on error
 /// @param[in] n_b the number of b timestamps within the array of b
 /// @param[in] b an array of timestamps for raw b data, null on error
 /// @param[in] n_iqrf the number of iq/rf timestamps within the array of iqrf
 /// @param[in] iqrf an array of timestamps for raw iq/rf data, null on error
-typedef void (*CusRawAvailabilityFn)(int res, int n_b, const long long* b, int n_iqrf, const long long* iqrf);
+/// @param[in] user the user data provided along with the callback
+typedef void (*CusRawAvailabilityFn)(int res, int n_b, const long long* b, int n_iqrf, const long long* iqrf, void* user);
 /// raw data request callback function
 /// @param[in] res the raw data result, typically the size of the data package requested or actually downloaded
 /// @param[in] extension the file extension of the packaged data
-typedef void (*CusRawRequestFn)(int res, const char* extension);
+/// @param[in] user the user data provided along with the callback
+typedef void (*CusRawRequestFn)(int res, const char* extension, void* user);
 /// raw data callback function
 /// @param[in] res the raw data result, typically the size of the data package requested or actually downloaded
-typedef void (*CusRawFn)(int res);
+/// @param[in] user the user data provided along with the callback
+typedef void (*CusRawFn)(int res, void* user);
+/// raw data chunk callback function
+/// @param[in] data the next chunk of the raw data package, only valid for the duration of the call
+/// @param[in] size size of the chunk in bytes
+/// @param[in] offset offset of the chunk within the package in bytes
+/// @param[in] user the user data provided along with the callback
+/// @return 0 to continue the download, or -1 to abort it
+typedef int (*CusRawChunkFn)(const void* data, int size, long long int offset, void* user);
+/// geometry callback function
+/// @param[in] geometry the geometry that is now live
+/// @param[in] user the user data provided along with the callback, or through CusInitParams::userData
+typedef void (*CusGeometryFn)(const CusGeometry* geometry, void* user);
 /// error callback function
 /// @param[in] code error code to associate with the error
 /// @param[in] msg the error message with associated error that occurred
-typedef void (*CusErrorFn)(CusErrorCode code, const char* msg);
+/// @param[in] user the user data provided through CusInitParams::userData
+typedef void (*CusErrorFn)(CusErrorCode code, const char* msg, void* user);
 /// tee connection callback function
 /// @param[in] connected flag associated with the tee having a disposable probe connection
 /// @param[in] serial if a probe is connected, the serial number of the probe
@@ -79,21 +112,27 @@ typedef void (*CusErrorFn)(CusErrorCode code, const char* msg);
 /// @param[in] id patient id if burned in to the probe
 /// @param[in] name patient name if burned in to the probe
 /// @param[in] exam exam id if burned in to the probe
-typedef void (*CusTeeConnectFn)(bool connected, const char* serial, double timeRemaining, const char* id, const char* name, const char* exam);
+/// @param[in] user the user data provided through CusInitParams::userData
+typedef void (*CusTeeConnectFn)(bool connected, const char* serial, double timeRemaining, const char* id, const char* name, const char* exam, void* user);
 /// new imu data streaming port function
 /// @param[in] port the new imu data UDP streaming port
-typedef void (*CusNewImuPortFn)(int port);
+/// @param[in] user the user data provided through CusInitParams::userData
+typedef void (*CusNewImuPortFn)(int port, void* user);
 /// new imu data callback function
 /// @param[in] pos the positional information data tagged with the image
-typedef void (*CusNewImuDataFn)(const CusPosInfo* pos);
+/// @param[in] user the user data provided through CusInitParams::userData
+typedef void (*CusNewImuDataFn)(const CusPosInfo* pos, void* user);
 /// imu calibration callback function
 /// @param[in] res the calibration result
-typedef void (*CusImuCalibrationFn)(CusImuCalibration res);
+/// @param[in] user the user data provided along with the callback
+typedef void (*CusImuCalibrationFn)(CusImuCalibration res, void* user);
 /// battery health callback function
 /// @param[in] res the health result
 /// @param[in] val the health value
-typedef void (*CusBatteryHealthFn)(CusBatteryHealth res, double val);
+/// @param[in] user the user data provided along with the callback
+typedef void (*CusBatteryHealthFn)(CusBatteryHealth res, double val, void* user);
 /// element test callback function
 /// @param[in] res the test result
 /// @param[in] val the test value
-typedef void (*CusElementTestFn)(CusElementTest res, double val);
+/// @param[in] user the user data provided through CusInitParams::userData
+typedef void (*CusElementTestFn)(CusElementTest res, double val, void* user);
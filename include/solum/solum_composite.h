@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+/// overlay compositing
+///
+/// blends a separated overlay (see solumSeparateOverlays) onto its grayscale frame. pixels are 32 bit ARGB values as
+/// delivered with the Uncompressed format, the overlay's alpha channel provides the coverage of each pixel, which is
+/// scaled by the opacity. the result is fully opaque. kernels are selected at compile time, avx2 when building with
+/// avx2 enabled (i.e. -mavx2) and neon on arm, and produce results identical to the scalar path.
+namespace solum
+{
+    namespace composite
+    {
+        /// converts an opacity into the fixed-point factor applied to the overlay's alpha
+        /// @param[in] opacity the opacity (0 - 1)
+        /// @return the factor, such that an opaque overlay pixel at full opacity weighs 256
+        inline uint32_t factor(double opacity)
+        {
+            opacity = (opacity < 0) ? 0 : ((opacity > 1) ? 1 : opacity);
+            return static_cast<uint32_t>(opacity * 257.0 + 0.5);
+        }
+
+        /// blends a single pixel
+        /// @param[in] bg the background pixel
+        /// @param[in] ov the overlay pixel
+        /// @param[in] k the opacity factor
+        /// @return the blended pixel
+        inline uint32_t blend(uint32_t bg, uint32_t ov, uint32_t k)
+        {
+            const uint32_t w = ((ov >> 24) * k + 128) >> 8;
+            uint32_t out = 0xff000000;
+            for (int shift = 0; shift < 24; shift += 8)
+            {
+                const uint32_t b = (bg >> shift) & 0xff, o = (ov >> shift) & 0xff;
+                out |= (((b * (256 - w)) + (o * w) + 128) >> 8) << shift;
+            }
+            return out;
+        }
+
+#if defined(__AVX2__)
+        /// blends 8 pixels
+        /// @param[in] bg the background pixels
+        /// @param[in] ov the overlay pixels
+        /// @param[in] k the opacity factor
+        /// @return the blended pixels
+        inline __m256i blend8(__m256i bg, __m256i ov, __m256i k)
+        {
+            const __m256i zero = _mm256_setzero_si256();
+            const __m256i round = _mm256_set1_epi16(128);
+            const __m256i full = _mm256_set1_epi16(256);
+
+            // per pixel weight, duplicated into both 16 bit halves so that unpacking lines it up with the channels
+            __m256i w = _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(_mm256_srli_epi32(ov, 24), k), _mm256_set1_epi32(128)), 8);
+            w = _mm256_or_si256(w, _mm256_slli_epi32(w, 16));
+            const __m256i wlo = _mm256_unpacklo_epi32(w, w), whi = _mm256_unpackhi_epi32(w, w);
+
+            auto mix = [&](__m256i b, __m256i o, __m256i wt)
+            {
+                __m256i v = _mm256_add_epi16(_mm256_mullo_epi16(b, _mm256_sub_epi16(full, wt)), _mm256_mullo_epi16(o, wt));
+                return _mm256_srli_epi16(_mm256_add_epi16(v, round), 8);
+            };
+
+            __m256i lo = mix(_mm256_unpacklo_epi8(bg, zero), _mm256_unpacklo_epi8(ov, zero), wlo);
+            __m256i hi = mix(_mm256_unpackhi_epi8(bg, zero), _mm256_unpackhi_epi8(ov, zero), whi);
+            return _mm256_or_si256(_mm256_packus_epi16(lo, hi), _mm256_set1_epi32(static_cast<int>(0xff000000)));
+        }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+        /// blends one channel of 8 pixels
+        /// @param[in] bg the background channel
+        /// @param[in] ov the overlay channel
+        /// @param[in] w the per pixel weights
+        /// @return the blended channel
+        inline uint8x8_t blend8(uint8x8_t bg, uint8x8_t ov, uint16x8_t w)
+        {
+            uint16x8_t v = vmulq_u16(vmovl_u8(bg), vsubq_u16(vdupq_n_u16(256), w));
+            v = vmlaq_u16(v, vmovl_u8(ov), w);
+            return vshrn_n_u16(vaddq_u16(v, vdupq_n_u16(128)), 8);
+        }
+
+        /// calculates the weights of 8 overlay pixels
+        /// @param[in] alpha the overlay alpha channel
+        /// @param[in] k the opacity factor
+        /// @return the per pixel weights
+        inline uint16x8_t weights8(uint8x8_t alpha, uint32_t k)
+        {
+            const uint16x8_t a = vmovl_u8(alpha);
+            const uint32x4_t lo = vshrq_n_u32(vmlaq_n_u32(vdupq_n_u32(128), vmovl_u16(vget_low_u16(a)), k), 8);
+            const uint32x4_t hi = vshrq_n_u32(vmlaq_n_u32(vdupq_n_u32(128), vmovl_u16(vget_high_u16(a)), k), 8);
+            return vcombine_u16(vmovn_u32(lo), vmovn_u32(hi));
+        }
+#endif
+    }
+
+    /// blends an ARGB overlay onto a grayscale frame
+    /// @param[in] gray the 8 bit grayscale frame
+    /// @param[in] overlay the ARGB overlay
+    /// @param[out] out the ARGB result, may not alias the inputs
+    /// @param[in] n the number of pixels
+    /// @param[in] opacity the opacity of the overlay (0 - 1), i.e. the StrainOpacity parameter divided by 100
+    inline void compositeGray(const uint8_t* gray, const uint32_t* overlay, uint32_t* out, size_t n, double opacity)
+    {
+        const uint32_t k = composite::factor(opacity);
+        size_t i = 0;
+#if defined(__AVX2__)
+        const __m256i kv = _mm256_set1_epi32(static_cast<int>(k));
+        const __m256i spread = _mm256_set1_epi32(0x00010101);
+        for (; i + 8 <= n; i += 8)
+        {
+            __m256i bg = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(gray + i)));
+            bg = _mm256_mullo_epi32(bg, spread);
+            __m256i ov = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(overlay + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), composite::blend8(bg, ov, kv));
+        }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+        for (; i + 8 <= n; i += 8)
+        {
+            const uint8x8_t g = vld1_u8(gray + i);
+            uint8x8x4_t ov = vld4_u8(reinterpret_cast<const uint8_t*>(overlay + i));
+            const uint16x8_t w = composite::weights8(ov.val[3], k);
+            ov.val[0] = composite::blend8(g, ov.val[0], w);
+            ov.val[1] = composite::blend8(g, ov.val[1], w);
+            ov.val[2] = composite::blend8(g, ov.val[2], w);
+            ov.val[3] = vdup_n_u8(0xff);
+            vst4_u8(reinterpret_cast<uint8_t*>(out + i), ov);
+        }
+#endif
+        for (; i < n; i++)
+            out[i] = composite::blend(static_cast<uint32_t>(gray[i]) * 0x00010101u, overlay[i], k);
+    }
+
+    /// blends an ARGB overlay onto an ARGB frame
+    /// @param[in] frame the ARGB frame
+    /// @param[in] overlay the ARGB overlay
+    /// @param[out] out the ARGB result, may be the same buffer as the frame
+    /// @param[in] n the number of pixels
+    /// @param[in] opacity the opacity of the overlay (0 - 1), i.e. the StrainOpacity parameter divided by 100
+    inline void compositeArgb(const uint32_t* frame, const uint32_t* overlay, uint32_t* out, size_t n, double opacity)
+    {
+        const uint32_t k = composite::factor(opacity);
+        size_t i = 0;
+#if defined(__AVX2__)
+        const __m256i kv = _mm256_set1_epi32(static_cast<int>(k));
+        for (; i + 8 <= n; i += 8)
+        {
+            __m256i bg = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(frame + i));
+            __m256i ov = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(overlay + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), composite::blend8(bg, ov, kv));
+        }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+        for (; i + 8 <= n; i += 8)
+        {
+            const uint8x8x4_t bg = vld4_u8(reinterpret_cast<const uint8_t*>(frame + i));
+            uint8x8x4_t ov = vld4_u8(reinterpret_cast<const uint8_t*>(overlay + i));
+            const uint16x8_t w = composite::weights8(ov.val[3], k);
+            ov.val[0] = composite::blend8(bg.val[0], ov.val[0], w);
+            ov.val[1] = composite::blend8(bg.val[1], ov.val[1], w);
+            ov.val[2] = composite::blend8(bg.val[2], ov.val[2], w);
+            ov.val[3] = vdup_n_u8(0xff);
+            vst4_u8(reinterpret_cast<uint8_t*>(out + i), ov);
+        }
+#endif
+        for (; i < n; i++)
+            out[i] = composite::blend(frame[i], overlay[i], k);
+    }
+}
@@ -0,0 +1,554 @@
+#pragma once
+
+#include "solum.h"
+
+/// context handle based api
+///
+/// every function of the global api that operates on the probe session has a variant taking a context,
+/// allowing multiple probes to be driven from a single process. each context owns its own connection,
+/// imaging pipeline and worker threads, and invokes the callbacks provided at its creation with the
+/// associated CusInitParams::userData.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /// creates and initializes a new context
+    /// @param[in] params the sdk configuration parameters for the context
+    /// @return the new context
+    /// @retval null the context could not be created
+    /// @note the global api functions continue to operate on the session set up by solumInit, which is independent of any context
+    SOLUM_EXPORT CusContext* solumCreate(const CusInitParams* params);
+
+    /// disconnects and cleans up memory allocated by a context
+    /// @param[in] ctx the context to destroy, the handle is no longer valid after the call
+    /// @return success of the call
+    /// @retval 0 the destroy attempt was successful
+    /// @retval -1 the destroy attempt was not successful
+    /// @note leased frames that were obtained through the context must be released prior to destroying it
+    SOLUM_EXPORT int solumCtxDestroy(CusContext* ctx);
+
+    /// sets a callback for the tee connectivity function
+    /// @param[in] ctx the context to operate on
+    /// @param[in] tee the callback function
+    /// @return success of the call
+    /// @retval 0 the function was successful
+    /// @retval -1 the function was not successful
+    SOLUM_EXPORT int solumCtxSetTeeFn(CusContext* ctx, CusTeeConnectFn tee);
+
+    /// connects to a probe that is on the same network as the caller
+    /// @param[in] ctx the context to operate on
+    /// @param[in] params the connection parameters
+    /// @return success of the call
+    /// @retval 0 the connection attempt was successful
+    /// @retval -1 the connection attempt was not successful
+    SOLUM_EXPORT int solumCtxConnect(CusContext* ctx, const CusConnectionParams* params);
+
+    /// disconnects from an existing connection
+    /// @param[in] ctx the context to operate on
+    /// @return success of the call
+    /// @retval 0 disconnection was successful
+    /// @retval -1 the disconnection was unsuccessful
+    SOLUM_EXPORT int solumCtxDisconnect(CusContext* ctx);
+
+    /// retrieves the current connected state of the module
+    /// @param[in] ctx the context to operate on
+    /// @return the connected state of the module
+    /// @retval 0 there is currently no connection
+    /// @retval 1 there is currently a connection
+    /// @retval -1 the module is not initialized
+    SOLUM_EXPORT int solumCtxIsConnected(CusContext* ctx);
+
+    /// sets the certificate for the probe to be connected with
+    /// @param[in] ctx the context to operate on
+    /// @param[in] cert the certificate provided by clarius
+    /// @return success of the call
+    /// @retval 0 the certificate update attempt was successful
+    /// @retval -1 the certificate update attempt was not successful
+    SOLUM_EXPORT int solumCtxSetCert(CusContext* ctx, const char* cert);
+
+    /// performs a software update once connected
+    /// @param[in] ctx the context to operate on
+    /// @param[in] path path to the firmware update file
+    /// @param[in] fn the callback function that reports the status
+    /// @param[in] progress software update progress callback
+    /// @param[in] hwVer optional hardware version to set if the library cannot determine version on initial tcp connection
+    ///                  set to 0, unless there is a reason to force the version (1, 2, or 3)
+    /// @param[in] user user data passed through to the callbacks
+    /// @return success of the call
+    /// @retval 0 the software is being sent
+    /// @retval -1 the software could not be sent
+    SOLUM_EXPORT int solumCtxSoftwareUpdate(CusContext* ctx, const char* path, CusSwUpdateFn fn, CusProgressFn progress, int hwVer, void* user);
+
+    /// retrieves the available probe models the api supports
+    /// @param[in] ctx the context to operate on
+    /// @param[in] fn the callback function that reports the list
+    /// @param[in] user user data passed through to the callbacks
+    /// @return success of the call
+    /// @retval 0 the information was retrieved
+    /// @retval -1 the information could not be retrieved
+    SOLUM_EXPORT int solumCtxProbes(CusContext* ctx, CusListFn fn, void* user);
+
+    /// retrieves the available applications for a specific probe model
+    /// @param[in] ctx the context to operate on
+    /// @param[in] probe the probe model to retrieve applications for
+    /// @param[in] fn the callback function that reports the list
+    /// @param[in] user user data passed through to the callbacks
+    /// @return success of the call
+    /// @retval 0 the information was retrieved
+    /// @retval -1 the information could not be retrieved
+    SOLUM_EXPORT int solumCtxApplications(CusContext* ctx, const char* probe, CusListFn fn, void* user);
+
+    /// loads an application
+    /// @param[in] ctx the context to operate on
+    /// @param[in] probe the probe model to load
+    /// @param[in] workflow the workflow to load
+    /// @return success of the call
+    /// @retval 0 the application was loaded
+    /// @retval -1 the application could not be loaded
+    SOLUM_EXPORT int solumCtxLoadApplication(CusContext* ctx, const char* probe, const char* workflow);
+
+    /// retrieves the current probe status if there's a connection
+    /// @param[in] ctx the context to operate on
+    /// @param[out] info the status information
+    /// @return success of the call
+    /// @retval 0 the information was retrieved
+    /// @retval -1 the information could not be retrieved
+    SOLUM_EXPORT int solumCtxStatusInfo(CusContext* ctx, CusStatusInfo* info);
+
+    /// retrieves the current probe information
+    /// @param[in] ctx the context to operate on
+    /// @param[out] info the probe information
+    /// @return success of the call
+    /// @retval 0 the information was retrieved
+    /// @retval -1 the information could not be retrieved
+    SOLUM_EXPORT int solumCtxProbeInfo(CusContext* ctx, CusProbeInfo* info);
+
+    /// sets the dimensions of the output display for scan conversion
+    /// @param[in] ctx the context to operate on
+    /// @param[in] w the number of pixels in the horizontal direction
+    /// @param[in] h the number of pixels in the vertical direction
+    /// @return success of the call
+    /// @retval 0 the output size was successfully programmed
+    /// @retval -1 the output size could not be set
+    /// @note the output will always result in a 1:1 pixel ratio, depending on geometry of scanning array, and parameters
+    ///       the frame will have various sizes of black borders around the image
+    SOLUM_EXPORT int solumCtxSetOutputSize(CusContext* ctx, int w, int h);
+
+    /// requests new dimensions of the output display for scan conversion without interrupting imaging
+    /// @param[in] ctx the context to operate on
+    /// @param[in] w the number of pixels in the horizontal direction
+    /// @param[in] h the number of pixels in the vertical direction
+    /// @param[in] fn callback made once the new size is live, holding the resulting geometry, may be null
+    /// @param[in] user user data passed to the callback
+    /// @return success of the call
+    /// @retval 0 the request was made
+    /// @retval -1 the request could not be made
+    /// @note frames keep being produced at the previous size until the pipeline is reconfigured. requests are coalesced,
+    ///       a request made while another is pending replaces it, and only the latest callback is made. the geometry callback
+    ///       provided through CusInitParams is made as well
+    /// @note the callback is made from a library thread at some later point, the user data must remain valid until then
+    SOLUM_EXPORT int solumCtxRequestOutputSize(CusContext* ctx, int w, int h, CusGeometryFn fn, void* user);
+
+    /// sets several output targets for scan conversion, all produced from a single reconstruction of each frame
+    /// @param[in] ctx the context to operate on
+    /// @param[in] sizes the dimensions of each target, the first being the target also set through solumCtxSetOutputSize()
+    /// @param[in] count the number of targets (1 - CUS_MAXOUTPUT)
+    /// @return success of the call
+    /// @retval 0 the output sizes were successfully programmed
+    /// @retval -1 the output sizes could not be set
+    /// @note the processed image callback is called once per target for each frame, one after the other in target order,
+    ///       with CusProcessedImageInfo::output holding the index of the target
+    SOLUM_EXPORT int solumCtxSetOutputSizes(CusContext* ctx, const CusOutputSize* sizes, int count);
+
+    /// sets a flag to separate overlays into separate images, for example if color/power Doppler or strain
+    /// imaging is enabled, two callbacks will be generated, one with the grayscale frame, and the other with the overlay
+    /// @param[in] ctx the context to operate on
+    /// @param[in] en the enable flag for separating overlays
+    /// @return success of the call
+    /// @retval 0 the flag was successfully programmed
+    /// @retval -1 the flag could not be set
+    SOLUM_EXPORT int solumCtxSeparateOverlays(CusContext* ctx, int en);
+
+    /// runs or stops imaging
+    /// @param[in] ctx the context to operate on
+    /// @param[in] run the run state to set, 0 to stop imaging, 1 to start imaging
+    /// @return success of the call
+    /// @retval 0 run request was successfully made
+    /// @retval -1 the run request could not be made
+    SOLUM_EXPORT int solumCtxRun(CusContext* ctx, int run);
+
+    /// retrieves the current imaging state of the probe
+    /// @param[in] ctx the context to operate on
+    /// @return the imaging state of the probe
+    /// @retval 0 the probe is not imaging
+    /// @retval 1 the probe is imaging
+    /// @retval -1 the module is not initialized
+    SOLUM_EXPORT int solumCtxIsImaging(CusContext* ctx);
+
+    /// shuts down the probe
+    /// @param[in] ctx the context to operate on
+    /// @return success of the call
+    /// @retval 0 shutdown was successful
+    /// @retval -1 the shutdown request could not be made
+    /// @note it is typically desirable to disconnect from bluetooth once the tcp connection has been established
+    ///       instead of relying on the power service, this function can be used to power down the probe over tcp
+    SOLUM_EXPORT int solumCtxPowerDown(CusContext* ctx);
+
+    /// sets the internal probe settings to be applied upon a connection or when an existing connection exists
+    /// @param[in] ctx the context to operate on
+    /// @param[in] settings the structure containing the probe settings
+    /// @return success of the call
+    /// @retval 0 the settings were successfully programmed
+    /// @retval -1 the settings could not be programmed
+    SOLUM_EXPORT int solumCtxSetProbeSettings(CusContext* ctx, const CusProbeSettings* settings);
+
+    /// sets an imaging parameter
+    /// @param[in] ctx the context to operate on
+    /// @param[in] param the parameter to set
+    /// @param[in] val the value to set the parameter to
+    /// @return success of the call
+    /// @retval 0 parameter set request successfully made
+    /// @retval -1 parameter set request could not be made
+    SOLUM_EXPORT int solumCtxSetParam(CusContext* ctx, CusParam param, double val);
+
+    /// retrieves an imaging parameter value
+    /// @param[in] ctx the context to operate on
+    /// @param[in] param the parameter to retrieve the value for
+    /// @return the parameter value
+    /// @retval -1 if the parameter value retrieval could not be made
+    SOLUM_EXPORT double solumCtxGetParam(CusContext* ctx, CusParam param);
+
+    /// retrieves the range for a specific parameter
+    /// @param[in] ctx the context to operate on
+    /// @param[in] param the parameter to retrieve the range for
+    /// @param[out] range holds the range values for the parameter queried
+    /// @return success of the call
+    /// @retval 0 if the range retrieval was made
+    /// @retval -1 if the range retrieval could not be made
+    SOLUM_EXPORT int solumCtxGetRange(CusContext* ctx, CusParam param, CusRange* range);
+
+    /// sets the tgc
+    /// @param[in] ctx the context to operate on
+    /// @param[in] tgc the value to set the tgc to
+    /// @return success of the call
+    /// @retval 0 tgc set request successfully made
+    /// @retval -1 tgc set request could not be made
+    SOLUM_EXPORT int solumCtxSetTgc(CusContext* ctx, const CusTgc* tgc);
+
+    /// retrieves the tgc values
+    /// @param[in] ctx the context to operate on
+    /// @param[out] tgc holds the tgc values
+    /// @return success of the call
+    /// @retval 0 tgc set request successfully made
+    /// @retval -1 tgc set request could not be made
+    SOLUM_EXPORT int solumCtxGetTgc(CusContext* ctx, CusTgc* tgc);
+
+    /// retrieves the active region for the grayscale image
+    /// @param[in] ctx the context to operate on
+    /// @param[out] points holds a vector of points in x/y format
+    /// @param[in] count the number of points to generate (points buffer must be count x 2 or larger)
+    /// @return success of the call
+    /// @retval 0 roi was retrieved
+    /// @retval -1 roi could not be retrieved
+    SOLUM_EXPORT int solumCtxGetActiveRegion(CusContext* ctx, double* points, int count);
+
+    /// retrieves the roi for the current mode if valid
+    /// @param[in] ctx the context to operate on
+    /// @param[out] points holds a vector of points in x/y format
+    /// @param[in] count the number of points to generate (points buffer must be count x 2 or larger)
+    /// @return success of the call
+    /// @retval 0 roi was retrieved
+    /// @retval -1 roi could not be retrieved
+    SOLUM_EXPORT int solumCtxGetRoi(CusContext* ctx, double* points, int count);
+
+    /// adjusts the roi based on the input provided
+    /// @param[in] ctx the context to operate on
+    /// @param[in] x the horizontal pixel position
+    /// @param[in] y the vertical pixel position
+    /// @param[in] fn roi function
+    /// @return success of the call
+    /// @retval 0 roi could be adjusted
+    /// @retval -1 roi could not be adjusted
+    SOLUM_EXPORT int solumCtxAdjustRoi(CusContext* ctx, int x, int y, CusRoiFunction fn);
+
+    /// maximizes the roi without having to manipulate or calculate pixel co-ordinates
+    /// @param[in] ctx the context to operate on
+    /// @return success of the call
+    /// @retval 0 roi could be adjusted
+    /// @retval -1 roi could not be adjusted
+    SOLUM_EXPORT int solumCtxMaximizeRoi(CusContext* ctx);
+
+    /// retrieves the gate for the current mode if valid
+    /// @param[in] ctx the context to operate on
+    /// @param[out] lines holds the lines that can be drawn to portray the gate on the image
+    /// @return success of the call
+    /// @retval 0 gate was retrieved
+    /// @retval -1 gate could not be retrieved
+    SOLUM_EXPORT int solumCtxGetGate(CusContext* ctx, CusGateLines* lines);
+
+    /// adjusts the gate based on the input provided
+    /// @param[in] ctx the context to operate on
+    /// @param[in] x the horizontal pixel position
+    /// @param[in] y the vertical pixel position
+    /// @return success of the call
+    /// @retval 0 gate could be adjusted
+    /// @retval -1 gate could not be adjusted
+    SOLUM_EXPORT int solumCtxAdjustGate(CusContext* ctx, int x, int y);
+
+    /// sets an imaging mode
+    /// @param[in] ctx the context to operate on
+    /// @param[in] mode the imaging mode to set
+    /// @return success of the call
+    /// @retval 0 mode set request successfully made
+    /// @retval -1 mode set request could not be made
+    SOLUM_EXPORT int solumCtxSetMode(CusContext* ctx, CusMode mode);
+
+    /// retrieves the current imaging mode
+    /// @param[in] ctx the context to operate on
+    /// @return the current imaging mode
+    SOLUM_EXPORT CusMode solumCtxGetMode(CusContext* ctx);
+
+    /// enables the 5v output on or off
+    /// @param[in] ctx the context to operate on
+    /// @param[in] en the enable state, set to 1 to turn 5v on, or 0 to turn off
+    /// @return success of the call
+    /// @retval 0 enable request successfully made
+    /// @retval -1 enable request could not be made
+    SOLUM_EXPORT int solumCtxEnable5v(CusContext* ctx, int en);
+
+    /// sets the format for processed images, by default the format will be uncompressed argb
+    /// @param[in] ctx the context to operate on
+    /// @param[in] format the format of the image
+    /// @return success of the call
+    /// @retval 0 the format was successfully set
+    /// @retval -1 the format could not be set
+    SOLUM_EXPORT int solumCtxSetFormat(CusContext* ctx, CusImageFormat format);
+
+    /// enables or disables the frame queue for a stream, allowing frames to be pulled with solumDequeueFrame
+    /// @param[in] ctx the context to operate on
+    /// @param[in] stream the stream to queue frames for
+    /// @param[in] depth the maximum number of frames held by the queue, 0 to disable the queue
+    /// @param[in] policy the policy applied when a frame arrives while the queue is full
+    /// @return success of the call
+    /// @retval 0 the queue was configured
+    /// @retval -1 the queue could not be configured
+    /// @note queued frames are delivered in addition to the stream's callback, leave the callback unset to only pull frames,
+    ///       each queued frame holds a lease, thus the frame pool depth should be larger than the combined queue depths
+    SOLUM_EXPORT int solumCtxSetFrameQueue(CusContext* ctx, CusStream stream, int depth, CusQueueOverflow policy);
+
+    /// pulls the oldest frame from a stream's frame queue
+    /// @param[in] ctx the context to operate on
+    /// @param[in] stream the stream to pull from
+    /// @param[in] timeoutMs the time to wait for a frame in milliseconds, 0 to return immediately, -1 to wait indefinitely
+    /// @param[out] frame holds the frame and its information, the frame must be released with solumFrameRelease
+    /// @return success of the call
+    /// @retval 0 a frame was dequeued
+    /// @retval 1 no frame arrived before the timeout expired
+    /// @retval -1 the queue is not enabled or was disabled while waiting
+    /// @note can be called from multiple consumer threads concurrently
+    SOLUM_EXPORT int solumCtxDequeueFrame(CusContext* ctx, CusStream stream, int timeoutMs, CusQueuedFrame* frame);
+
+    /// retrieves the statistics of a stream's frame queue
+    /// @param[in] ctx the context to operate on
+    /// @param[in] stream the stream to retrieve the statistics for
+    /// @param[out] stats holds the queue statistics
+    /// @return success of the call
+    /// @retval 0 the statistics were retrieved
+    /// @retval -1 the statistics could not be retrieved
+    SOLUM_EXPORT int solumCtxFrameQueueStats(CusContext* ctx, CusStream stream, CusQueueStats* stats);
+
+    /// retrieves the pipeline metrics accumulated since initialization or the last reset
+    /// @param[in] ctx the context to operate on
+    /// @param[out] metrics holds the metrics
+    /// @return success of the call
+    /// @retval 0 the metrics were retrieved
+    /// @retval -1 the metrics could not be retrieved
+    SOLUM_EXPORT int solumCtxGetMetrics(CusContext* ctx, CusMetrics* metrics);
+
+    /// resets all pipeline metrics
+    /// @param[in] ctx the context to operate on
+    /// @return success of the call
+    /// @retval 0 the metrics were reset
+    /// @retval -1 the metrics could not be reset
+    SOLUM_EXPORT int solumCtxResetMetrics(CusContext* ctx);
+
+    /// will try and optimize the wireless channel when the probe is running its own network
+    /// the function will return a failure if the probe is on an external wlan as nothing can be optimized, except for switching over to the probe's own network
+    /// to switch to the probe's network, see the bluetooth documentation for the wireless management service
+    /// @param[in] ctx the context to operate on
+    /// @param[in] opt the optimization type to run
+    /// @return success of the call
+    /// @retval 0 the optimization is being performed
+    /// @retval -1 the optimization could not be performed
+    /// @note on some platforms it may be necessary to run the operation of re-connecting to the network through the operating system.
+    ///       it will not be necessary to re-parse the connection data through the bluetooth service, as ip address and port will not change after optimization
+    SOLUM_EXPORT int solumCtxOptimizeWifi(CusContext* ctx, CusWifiOpt opt);
+
+    /// performs a reset of a function on the probe
+    /// @param[in] ctx the context to operate on
+    /// @param[in] reset the reset type to perform
+    /// @return success of the call
+    /// @retval 0 the reset is being performed
+    /// @retval -1 the reset could not be performed
+    SOLUM_EXPORT int solumCtxResetProbe(CusContext* ctx, CusProbeReset reset);
+
+    /// makes a request to return the availability of all the raw data currently buffered on the probe
+    /// @param[in] ctx the context to operate on
+    /// @param[in] fn result callback function that will return all the timestamps of the data blocks that are buffered
+    /// @param[in] user user data passed through to the callbacks
+    /// @return success of the call
+    /// @retval 0 the request was successfully made
+    /// @retval -1 the request could not be made
+    /// @note the probe must be frozen with raw data buffering enabled prior to calling the function
+    SOLUM_EXPORT int solumCtxRawDataAvailability(CusContext* ctx, CusRawAvailabilityFn fn, void* user);
+
+    /// makes a request for raw data from the probe
+    /// @param[in] ctx the context to operate on
+    /// @param[in] start the first frame to request, as determined by timestamp in nanoseconds, set to 0 along with end to requests all data in buffer
+    /// @param[in] end the last frame to request, as determined by timestamp in nanoseconds, set to 0 along with start to requests all data in buffer
+    /// @param[in] lzo flag to specify a tarball with lzo compressed raw data inside (default) vs no compression of raw data
+    /// @param[in] fn result callback function, will return size of buffer required upon success, 0 if no raw data was buffered, or -1 if request could not be made
+    /// @param[in] user user data passed through to the callbacks
+    /// @return success of the call
+    /// @retval 0 the request was successfully made
+    /// @retval -1 the request could not be made
+    /// @note the probe must be frozen and in a raw data buffering mode in order for the call to succeed
+    SOLUM_EXPORT int solumCtxRequestRawData(CusContext* ctx, long long int start, long long int end, int lzo, CusRawRequestFn fn, void* user);
+
+    /// makes a request for a selection of the raw data from the probe
+    /// @param[in] ctx the context to operate on
+    /// @param[in] params the request parameters
+    /// @param[in] fn result callback function, will return size of buffer required upon success, 0 if no raw data matched the selection, or -1 if request could not be made
+    /// @param[in] user user data passed through to the callbacks
+    /// @return success of the call
+    /// @retval 0 the request was successfully made
+    /// @retval -1 the request could not be made
+    /// @note the probe must be frozen and in a raw data buffering mode in order for the call to succeed
+    SOLUM_EXPORT int solumCtxRequestRawDataSelection(CusContext* ctx, const CusRawRequestParams* params, CusRawRequestFn fn, void* user);
+
+    /// retrieves raw data from a previous request
+    /// @param[in] ctx the context to operate on
+    /// @param[out] data a pointer to a buffer that has been allocated to read the raw data into, this must be pre-allocated with
+    ///             the size returned from a previous call to solumRequestRawData
+    /// @param[in] fn result callback function, will return size of buffer required upon success, 0 if no raw data was buffered, or -1 if request could not be made,
+    /// @param[in] progress download progress callback function that outputs the progress in percent
+    /// @param[in] user user data passed through to the callbacks
+    /// @return success of the call
+    /// @retval 0 the read request was successfully made
+    /// @retval -1 the read request could not be made
+    /// @note the probe must be frozen and a successful call to solumRequestRawData must have taken place in order for the call to succeed
+    SOLUM_EXPORT int solumCtxReadRawData(CusContext* ctx, void** data, CusRawFn fn, CusProgressFn progress, void* user);
+
+    /// retrieves raw data from a previous request in chunks, such that packages of any size download with a fixed size buffer
+    /// @param[in] ctx the context to operate on
+    /// @param[in] chunkSize size of the chunks in bytes, 0 for the default of 1 MB
+    /// @param[in] sink chunk callback function, called for each chunk in the order of the package, aborting the download when it fails
+    /// @param[in] fn result callback function, will return the size of the package upon success, or -1 if the download failed or was aborted
+    /// @param[in] progress download progress callback function that outputs the progress in percent
+    /// @param[in] user user data passed through to the callbacks
+    /// @return success of the call
+    /// @retval 0 the read request was successfully made
+    /// @retval -1 the read request could not be made
+    /// @note the probe must be frozen and a successful call to solumRequestRawData must have taken place in order for the call to succeed
+    SOLUM_EXPORT int solumCtxReadRawDataStream(CusContext* ctx, int chunkSize, CusRawChunkFn sink, CusRawFn fn, CusProgressFn progress, void* user);
+
+    /// resumes retrieving raw data from a previous request in chunks, skipping the part of the package already received
+    /// @param[in] ctx the context to operate on
+    /// @param[in] offset offset within the package to resume from in bytes, i.e. the number of bytes the sink stored before the download failed
+    /// @param[in] chunkSize size of the chunks in bytes, 0 for the default of 1 MB
+    /// @param[in] retries number of times a chunk that fails its checksum or times out is requested again before the download fails
+    /// @param[in] sink chunk callback function, called for each chunk in the order of the package, aborting the download when it fails
+    /// @param[in] fn result callback function, will return the size of the package upon success, or -1 if the download failed or was aborted
+    /// @param[in] progress download progress callback function that outputs the progress in percent of the whole package, including the bytes skipped
+    /// @param[in] user user data passed through to the callbacks
+    /// @return success of the call
+    /// @retval 0 the read request was successfully made
+    /// @retval -1 the read request could not be made
+    /// @note the probe must remain frozen since the request, as a new request or imaging discards the package
+    SOLUM_EXPORT int solumCtxReadRawDataResume(CusContext* ctx, long long int offset, int chunkSize, int retries, CusRawChunkFn sink, CusRawFn fn, CusProgressFn progress, void* user);
+
+    /// sets a low level parameter to a specific value to gain access to lower level device control
+    /// @param[in] ctx the context to operate on
+    /// @param[in] prm the parameter to change
+    /// @param[in] val the value to set the parameter to
+    /// @return success of the call
+    /// @retval 0 the call was successful
+    /// @retval -1 the call was not successful
+    /// @note see external documentation for supported parameters
+    /// @warning changing parameters through this function may result in unstable operation, degradation of image quality, or operation outside of the safety limits that clarius tests to
+    SOLUM_EXPORT int solumCtxSetLowLevelParam(CusContext* ctx, const char* prm, double val);
+
+    /// enables or disables a low level parameter to gain access to lower device control
+    /// @param[in] ctx the context to operate on
+    /// @param[in] prm the parameter to change
+    /// @param[in] en the enable flag, 0 to disable, 1 to enable
+    /// @return success of the call
+    /// @retval 0 the call was successful
+    /// @retval -1 the call was not successful
+    /// @note see external documentation for supported parameters
+    /// @warning changing parameters through this function may result in unstable operation, degradation of image quality, or operation outside of the safety limits that clarius tests to
+    SOLUM_EXPORT int solumCtxEnableLowLevelParam(CusContext* ctx, const char* prm, int en);
+
+    /// sets a pulse shape parameter to a specific value to gain access to lower level device control
+    /// @param[in] ctx the context to operate on
+    /// @param[in] prm the parameter to change
+    /// @param[in] shape the shape to set the pulse as
+    /// @return success of the call
+    /// @retval 0 the call was successful
+    /// @retval -1 the call was not successful
+    /// @note see external documentation for supported parameters
+    /// @warning changing parameters through this function may result in unstable operation, degradation of image quality, or operation outside of the safety limits that clarius tests to
+    SOLUM_EXPORT int solumCtxSetLowLevelPulse(CusContext* ctx, const char* prm, const char* shape);
+
+    /// retrieves a low level parameter value
+    /// @param[in] ctx the context to operate on
+    /// @param[in] prm the parameter to retrieve the value for
+    /// @return the parameter value, for boolean variables, the value will be 0 (disabled) or 1 (enabled)
+    /// @retval -1 if the parameter value retrieval could not be made
+    SOLUM_EXPORT double solumCtxGetLowLevelParam(CusContext* ctx, const char* prm);
+
+    /// retrieves the acoustic indices for the loaded application, imaging mode, and parameter settings
+    /// @param[in] ctx the context to operate on
+    /// @param[out] indices the acoustic index values
+    /// @return success of the call
+    /// @retval 0 the call was successful
+    /// @retval -1 the call was not successful
+    SOLUM_EXPORT int solumCtxGetAcousticIndices(CusContext* ctx, CusAcoustic* indices);
+
+    /// set the tee exam info for a connected probe
+    /// @param[in] ctx the context to operate on
+    /// @param[in] id the patient id
+    /// @param[in] name the patient name
+    /// @param[in] exam the exam id
+    /// @return success of the call
+    /// @retval 0 the function was successful
+    /// @retval -1 the function was not successful
+    SOLUM_EXPORT int solumCtxSetTeeExamInfo(CusContext* ctx, const char* id, const char* name, const char* exam);
+
+    /// calibrates the imu
+    /// @param[in] ctx the context to operate on
+    /// @param[in] stationary set to 1 if calibrating for stationary detection, 0 for motion calibration
+    /// @param[in] fn the callback upon calibration completion
+    /// @param[in] progress the callback for calibration completion rate
+    /// @param[in] user user data passed through to the callbacks
+    /// @return success of the call
+    /// @note the probe must be frozen to calibrate the imu
+    /// @retval 0 the call was successful
+    /// @retval -1 the call was not successful
+    SOLUM_EXPORT int solumCtxCalibrateImu(CusContext* ctx, int stationary, CusImuCalibrationFn fn, CusProgressFn progress, void* user);
+
+    /// runs a battery health test
+    /// @param[in] ctx the context to operate on
+    /// @param[in] fn the callback upon test completion
+    /// @param[in] user user data passed through to the callbacks
+    /// @return success of the call
+    /// @note the probe must be frozen to run the battery health test
+    ///       this check may take up to 10 seconds to return a result
+    /// @retval 0 the call was successful
+    /// @retval -1 the call was not successful
+    SOLUM_EXPORT int solumCtxBatteryHealth(CusContext* ctx, CusBatteryHealthFn fn, void* user);
+
+#ifdef __cplusplus
+}
+#endif
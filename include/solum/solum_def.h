@@ -1,9 +1,17 @@
 #pragma once
 
 // SDK: solum
-// Version: 12.2.4
+// Version: 13.0.0
+
+#define CUS_VERSION_MAJOR 13 ///< raised with every change breaking source or binary compatibility
+#define CUS_VERSION_MINOR 0
+#define CUS_VERSION_PATCH 0
 
 #define CUS_MAXTGC  10
+#define CUS_MAXSTREAM 3 ///< number of image streams (see CusStream)
+#define CUS_MAXLATENCY 16 ///< number of buckets in a latency histogram
+#define CUS_MAXOUTPUT 4 ///< maximum number of processed image output targets
+#define CUS_MAXROI 32 ///< number of points describing a roi
 #define CUS_SUCCESS 0
 #define CUS_FAILURE (-1)
 #define CERT_INVALID (-1) ///< certificate is not valid
@@ -24,6 +32,7 @@ typedef enum _CusImageFormat
     Uncompressed8Bit,   ///< Processed images are sent in a raw and uncompressed in 8 bit grayscale
     Jpeg,               ///< Processed images are sent as a jpeg (with header)
     Png,                ///< Processed images are sent as a png (with header)
+    Delta8Bit,          ///< Processed images are sent in 8 bit grayscale, coded losslessly against the previous frame (see solum_delta.h)
 
 } CusImageFormat;
 
@@ -123,6 +132,14 @@ typedef enum _CusImagingState
 
 } CusImagingState;
 
+/// Frame queue overflow policies
+typedef enum _CusQueueOverflow
+{
+    QueueDropOldest,    ///< Drop the oldest queued frame to make room for the new frame
+    QueueBlock,         ///< Block the library until a frame is dequeued, which may in turn drop frames on the network
+
+} CusQueueOverflow;
+
 /// Imu calibration results
 typedef enum _CusImuCalibration
 {
@@ -158,6 +175,23 @@ typedef enum _CusLogLevel
 
 } CusLogLevel;
 
+/// Trace file formats
+typedef enum _CusTraceFormat
+{
+    TraceChromeJson,    ///< Chrome trace event json, viewable through chrome://tracing or ui.perfetto.dev
+    TracePerfetto,      ///< Perfetto protobuf trace
+
+} CusTraceFormat;
+
+/// Raw data streams, combined into a mask to select the streams of a raw data request
+typedef enum _CusRawStream
+{
+    RawStreamB = 0x1,   ///< Envelope (B) data
+    RawStreamIq = 0x2,  ///< IQ data
+    RawStreamRf = 0x4,  ///< RF data
+
+} CusRawStream;
+
 /// Imaging modes
 typedef enum _CusMode
 {
@@ -205,6 +239,15 @@ typedef enum _CusParam
 
 } CusParam;
 
+/// Frame streams
+typedef enum _CusStream
+{
+    StreamProcessed,    ///< Processed (scan-converted) images
+    StreamRaw,          ///< Raw images (pre scan-converted or rf data)
+    StreamSpectral,     ///< Processed spectral images
+
+} CusStream;
+
 /// Power down reason
 typedef enum _CusPowerDown
 {
@@ -301,6 +344,14 @@ typedef struct _CusProbeInfo
 
 } CusProbeInfo;
 
+/// Processed image output target
+typedef struct _CusOutputSize
+{
+    int width;          ///< width of the output in pixels
+    int height;         ///< height of the output in pixels
+
+} CusOutputSize;
+
 /// Processed image information supplied with each frame
 typedef struct _CusProcessedImageInfo
 {
@@ -317,6 +368,8 @@ typedef struct _CusProcessedImageInfo
     int overlay;        ///< flag that the image is an overlay without grayscale (ie. color doppler or strain)
     CusImageFormat format; ///< flag specifying the format of the image (see format definitions above)
     CusTgcInfo tgc [CUS_MAXTGC]; ///< tgc points
+    int output;         ///< index of the output target the image was produced for (see solumSetOutputSizes)
+    long long int generation; ///< generation of the geometry the image was produced with (see CusGeometry)
 
 } CusProcessedImageInfo;
 
@@ -447,10 +500,125 @@ typedef struct _CusGateLines
 
 } CusGateLines;
 
+/// Image geometry, describing the regions that can be drawn over processed images in pixel co-ordinates
+typedef struct _CusGeometry
+{
+    int width;          ///< Width of the output in pixels
+    int height;         ///< Height of the output in pixels
+    double micronsPerPixel; ///< Microns per pixel
+    double originX;     ///< Image origin in microns in the horizontal axis
+    double originY;     ///< Image origin in microns in the vertical axis
+    CusPointF activeRegion[4]; ///< Active region for the grayscale image, for sector probes the first 2 and last 2 points lie on arcs
+    int roi;            ///< Flag that the current mode has a roi
+    CusPointF roiPoints[CUS_MAXROI]; ///< Roi for the current mode, valid if the roi flag is set
+    int gate;           ///< Flag that the current mode has a gate
+    CusGateLines gateLines; ///< Gate for the current mode, valid if the gate flag is set
+    long long int generation; ///< Generation of the geometry, incremented on every change
+
+} CusGeometry;
+
+/// Leased frame handle
+///
+/// Refers to a buffer from the library-owned frame pool. The buffer stays valid for the duration of
+/// the callback that delivered it, or until released if it was acquired by the application.
+typedef struct _CusFrame CusFrame;
+
+/// Frame pulled from a frame queue
+typedef struct _CusQueuedFrame
+{
+    CusStream stream;   ///< Stream the frame belongs to
+    CusFrame* frame;    ///< Leased frame, must be released with solumFrameRelease
+    CusProcessedImageInfo processed; ///< Image information, valid for processed streams
+    CusRawImageInfo raw; ///< Image information, valid for raw streams
+    CusSpectralImageInfo spectral; ///< Image information, valid for spectral streams
+
+} CusQueuedFrame;
+
+/// Frame queue statistics
+typedef struct _CusQueueStats
+{
+    int depth;          ///< Maximum number of frames held by the queue, 0 if the queue is disabled
+    int count;          ///< Number of frames currently held by the queue
+    long long int queued; ///< Total number of frames pushed into the queue
+    long long int dequeued; ///< Total number of frames pulled from the queue
+    long long int dropped; ///< Total number of frames dropped due to the overflow policy
+
+} CusQueueStats;
+
+/// Latency histogram
+///
+/// Bucket 0 counts samples below 64 microseconds, each following bucket doubles the upper bound, and the last bucket
+/// counts every sample above its lower bound (roughly 1 second).
+typedef struct _CusLatency
+{
+    long long int count; ///< Number of samples
+    double mean;        ///< Mean latency in microseconds
+    double max;         ///< Maximum latency in microseconds
+    long long int buckets[CUS_MAXLATENCY]; ///< Sample counts per bucket
+
+} CusLatency;
+
+/// Per-stream pipeline metrics
+typedef struct _CusStreamMetrics
+{
+    long long int packetsReceived; ///< Udp packets received
+    long long int packetsLost; ///< Udp packets detected as missing from the sequence
+    long long int framesReassembled; ///< Frames fully reassembled from packets
+    long long int framesDropped; ///< Frames discarded due to missing packets or a full queue
+    long long int bytes; ///< Payload bytes received
+    CusLatency decode;  ///< Time spent decoding (i.e. jpeg/png or raw decompression)
+    CusLatency scanConversion; ///< Time spent reconstructing the image, only for processed images
+    CusLatency dispatch; ///< Time spent in the application's callback
+    CusLatency endToEnd; ///< Time from the probe timestamp to the callback, subject to the clock offset between probe and host
+
+} CusStreamMetrics;
+
+/// Pipeline metrics
+typedef struct _CusMetrics
+{
+    long long int elapsed; ///< Nanoseconds since the metrics were last reset
+    CusStreamMetrics streams[CUS_MAXSTREAM]; ///< Metrics indexed by CusStream
+
+} CusMetrics;
+
+/// Image stream ingest settings
+///
+/// Controls how the UDP image stream is received, a value of 0 selects the library default for any field.
+typedef struct _CusIngestParams
+{
+    int socketBufferSize; ///< Size of the socket receive buffer (SO_RCVBUF) in bytes, capped by the host (i.e. net.core.rmem_max on linux)
+    int batchSize;      ///< Maximum number of datagrams read per system call (recvmmsg where available), 1 disables batching
+    int receiveThread;  ///< Flag to receive on a dedicated thread rather than the shared network thread
+    int cpuAffinity;    ///< Cpu core to pin the dedicated receive thread to, -1 for no affinity
+
+} CusIngestParams;
+
+/// Raw data request parameters
+typedef struct _CusRawRequestParams
+{
+    long long int start; ///< First frame to request, as determined by timestamp in nanoseconds, set to 0 along with end to request all data in the buffer
+    long long int end;  ///< Last frame to request, as determined by timestamp in nanoseconds, set to 0 along with start to request all data in the buffer
+    int lzo;            ///< Flag to package the raw data lzo compressed
+    int streams;        ///< Mask of the streams to package (see CusRawStream), 0 for all streams
+    int decimation;     ///< Package every nth frame within the range, 1 for every frame
+    int lineStart;      ///< First line to package
+    int lineCount;      ///< Number of lines to package, 0 for all lines from the first
+    int sampleStart;    ///< First sample of each line to package
+    int sampleCount;    ///< Number of samples per line to package, 0 for all samples from the first
+
+} CusRawRequestParams;
+
+/// Context handle
+///
+/// Refers to an independent probe session created with solumCreate.
+typedef struct _CusContext CusContext;
+
 /// SDK configuration
 typedef struct _CusConfig
 {
     CusLogLevel logLevel; ///< Logging level
+    const char* tracePath; ///< File to write a trace of library events to, null to disable tracing
+    CusTraceFormat traceFormat; ///< Format of the trace file
 
 } CusConfig;
 
@@ -0,0 +1,361 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/// temporal delta codec for 8 bit grayscale images (see Delta8Bit)
+///
+/// every frame is coded losslessly as residuals against a prediction, keyframes predict each pixel from its
+/// neighbours (median edge detector) while delta frames predict each pixel from the previous frame. residuals are
+/// zigzag mapped and rice coded in blocks of 64 pixels, each block picking its own rice parameter, with blocks of zero
+/// residuals (i.e. borders or static regions) costing 3 bits. delta frames reference the sequence number of the frame
+/// they were predicted from, thus a decoder that missed a frame waits for the next keyframe rather than drifting.
+///
+/// packet layout (little endian):
+///   magic (1) | type (1) | width (2) | height (2) | reserved (2) | sequence (4) | reference (4) | payload
+namespace solum
+{
+    namespace delta
+    {
+        static constexpr uint8_t Magic = 0xd7;          ///< packet identifier
+        static constexpr uint8_t KeyFrame = 0;          ///< frame predicted spatially
+        static constexpr uint8_t DeltaFrame = 1;        ///< frame predicted from the reference frame
+        static constexpr size_t HeaderSize = 16;        ///< size of the packet header
+        static constexpr int BlockSize = 64;            ///< pixels per rice block
+        static constexpr uint32_t ZeroBlock = 7;        ///< block code for all zero residuals
+        static constexpr uint32_t Escape = 16;          ///< unary length after which the value is stored verbatim
+
+        /// median edge detector prediction
+        /// @param[in] img the image
+        /// @param[in] i the pixel index
+        /// @param[in] x the horizontal position
+        /// @param[in] y the vertical position
+        /// @param[in] w the image width
+        /// @return the predicted value
+        inline uint8_t predict(const uint8_t* img, size_t i, int x, int y, int w)
+        {
+            if (!y)
+                return x ? img[i - 1] : 0;
+            if (!x)
+                return img[i - w];
+            const int a = img[i - 1], b = img[i - w], c = img[i - w - 1];
+            const int mn = a < b ? a : b, mx = a < b ? b : a;
+            return static_cast<uint8_t>(c >= mx ? mn : (c <= mn ? mx : a + b - c));
+        }
+
+        /// maps a residual to an unsigned value, small magnitudes giving small values
+        inline uint32_t zigzag(uint8_t r) { const int s = static_cast<int8_t>(r); return ((static_cast<uint32_t>(s) << 1) ^ static_cast<uint32_t>(s >> 7)) & 0xff; }
+        /// reverses the zigzag mapping
+        inline uint8_t unzigzag(uint32_t u) { return static_cast<uint8_t>((u >> 1) ^ (0u - (u & 1))); }
+
+        /// counts the leading one bits of a value
+        inline int leadingOnes(uint32_t v)
+        {
+            v = ~v;
+#if defined(__GNUC__) || defined(__clang__)
+            return v ? __builtin_clz(v) : 32;
+#else
+            int n = 0;
+            while (n < 32 && !(v & 0x80000000u))
+            {
+                v <<= 1;
+                n++;
+            }
+            return n;
+#endif
+        }
+
+        /// msb first bit writer
+        class BitWriter
+        {
+        public:
+            explicit BitWriter(std::vector<uint8_t>& out) : out_(out), acc_(0), bits_(0) { }
+
+            /// writes up to 32 bits
+            void write(uint32_t v, int n)
+            {
+                acc_ = (acc_ << n) | (v & ((n == 32) ? 0xffffffffu : ((1u << n) - 1)));
+                bits_ += n;
+                while (bits_ >= 8)
+                {
+                    bits_ -= 8;
+                    out_.push_back(static_cast<uint8_t>(acc_ >> bits_));
+                }
+            }
+
+            /// pads the last byte with zeros
+            void flush()
+            {
+                if (bits_)
+                    out_.push_back(static_cast<uint8_t>(acc_ << (8 - bits_)));
+                bits_ = 0;
+            }
+
+        private:
+            std::vector<uint8_t>& out_; ///< output
+            uint64_t acc_;              ///< pending bits
+            int bits_;                  ///< number of pending bits
+        };
+
+        /// msb first bit reader, reading past the end yields zeros
+        class BitReader
+        {
+        public:
+            BitReader(const uint8_t* data, size_t size) : data_(data), end_(data + size), acc_(0), bits_(0), avail_(size * 8), used_(0) { }
+
+            /// peeks at the next 32 bits
+            uint32_t peek()
+            {
+                while (bits_ <= 56)
+                {
+                    acc_ |= static_cast<uint64_t>(data_ < end_ ? *data_++ : 0) << (56 - bits_);
+                    bits_ += 8;
+                }
+                return static_cast<uint32_t>(acc_ >> 32);
+            }
+
+            /// skips bits that were peeked at
+            void skip(int n)
+            {
+                acc_ <<= n;
+                bits_ -= n;
+                used_ += static_cast<size_t>(n);
+            }
+
+            /// reads up to 32 bits
+            uint32_t read(int n)
+            {
+                if (!n)
+                    return 0;
+                auto v = peek() >> (32 - n);
+                skip(n);
+                return v;
+            }
+
+            /// @return true if more bits were consumed than available
+            bool overrun() const { return used_ > avail_; }
+
+        private:
+            const uint8_t* data_;   ///< next byte to load
+            const uint8_t* end_;    ///< end of the data
+            uint64_t acc_;          ///< loaded bits, msb first
+            int bits_;              ///< number of loaded bits
+            size_t avail_;          ///< number of bits available
+            size_t used_;           ///< number of bits consumed
+        };
+
+        inline void put16(uint8_t* p, uint32_t v) { p[0] = static_cast<uint8_t>(v); p[1] = static_cast<uint8_t>(v >> 8); }
+        inline void put32(uint8_t* p, uint32_t v) { put16(p, v); put16(p + 2, v >> 16); }
+        inline uint32_t get16(const uint8_t* p) { return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8); }
+        inline uint32_t get32(const uint8_t* p) { return get16(p) | (get16(p + 2) << 16); }
+    }
+
+    /// encodes 8 bit grayscale frames
+    class DeltaEncoder
+    {
+    public:
+        /// default constructor
+        /// @param[in] keyInterval the number of frames between keyframes, 1 or less to only produce keyframes
+        explicit DeltaEncoder(int keyInterval = 30) : keyInterval_(keyInterval), count_(0), seq_(0), width_(0), height_(0) { }
+
+        /// forces the next frame to be a keyframe
+        void forceKey() { count_ = 0; }
+
+        /// encodes a frame
+        /// @param[in] img the image, width * height pixels
+        /// @param[in] width the image width (1 - 65535)
+        /// @param[in] height the image height (1 - 65535)
+        /// @param[out] out holds the encoded packet
+        /// @return size of the packet in bytes, 0 if the dimensions are invalid
+        size_t encode(const uint8_t* img, int width, int height, std::vector<uint8_t>& out)
+        {
+            out.clear();
+            if (width <= 0 || height <= 0 || width > 0xffff || height > 0xffff)
+                return 0;
+
+            const size_t n = static_cast<size_t>(width) * height;
+            const bool key = (width != width_ || height != height_ || keyInterval_ <= 1 || (count_ % keyInterval_) == 0);
+            const uint32_t ref = seq_;
+            seq_++;
+            count_ = key ? 1 : count_ + 1;
+
+            // prediction residuals
+            residuals_.resize(n);
+            if (key)
+            {
+                size_t i = 0;
+                for (int y = 0; y < height; y++)
+                    for (int x = 0; x < width; x++, i++)
+                        residuals_[i] = static_cast<uint8_t>(delta::zigzag(static_cast<uint8_t>(img[i] - delta::predict(img, i, x, y, width))));
+            }
+            else
+            {
+                const uint8_t* prev = ref_.data();
+                for (size_t i = 0; i < n; i++)
+                    residuals_[i] = static_cast<uint8_t>(delta::zigzag(static_cast<uint8_t>(img[i] - prev[i])));
+            }
+
+            out.resize(delta::HeaderSize);
+            out[0] = delta::Magic;
+            out[1] = key ? delta::KeyFrame : delta::DeltaFrame;
+            delta::put16(&out[2], static_cast<uint32_t>(width));
+            delta::put16(&out[4], static_cast<uint32_t>(height));
+            delta::put16(&out[6], 0);
+            delta::put32(&out[8], seq_);
+            delta::put32(&out[12], key ? 0 : ref);
+            out.reserve(delta::HeaderSize + n / 2);
+
+            delta::BitWriter bw(out);
+            for (size_t b = 0; b < n; b += delta::BlockSize)
+            {
+                const size_t e = (b + delta::BlockSize < n) ? b + delta::BlockSize : n;
+                uint32_t sum = 0;
+                for (size_t i = b; i < e; i++)
+                    sum += residuals_[i];
+                if (!sum)
+                {
+                    bw.write(delta::ZeroBlock, 3);
+                    continue;
+                }
+                // choose the parameter from the mean of the block, i.e. k = floor(log2(mean))
+                uint32_t k = 0;
+                while (k < delta::ZeroBlock - 1 && ((static_cast<uint32_t>(e - b) << (k + 1)) <= sum))
+                    k++;
+                bw.write(k, 3);
+                for (size_t i = b; i < e; i++)
+                {
+                    const uint32_t u = residuals_[i], q = u >> k;
+                    if (q < delta::Escape)
+                    {
+                        bw.write(((1u << q) - 1) << 1, static_cast<int>(q) + 1);
+                        bw.write(u, static_cast<int>(k));
+                    }
+                    else
+                    {
+                        bw.write((1u << delta::Escape) - 1, delta::Escape);
+                        bw.write(u, 8);
+                    }
+                }
+            }
+            bw.flush();
+
+            width_ = width;
+            height_ = height;
+            ref_.assign(img, img + n);
+            return out.size();
+        }
+
+    private:
+        int keyInterval_;               ///< frames between keyframes
+        int count_;                     ///< frames since the last keyframe
+        uint32_t seq_;                  ///< sequence number of the last frame
+        int width_;                     ///< width of the reference frame
+        int height_;                    ///< height of the reference frame
+        std::vector<uint8_t> ref_;      ///< reference frame
+        std::vector<uint8_t> residuals_;///< residual buffer
+    };
+
+    /// decodes 8 bit grayscale frames
+    class DeltaDecoder
+    {
+    public:
+        DeltaDecoder() : seq_(0), width_(0), height_(0), valid_(false) { }
+
+        /// decodes a packet
+        /// @param[in] data the packet
+        /// @param[in] size size of the packet in bytes
+        /// @return success of the call
+        /// @retval 0 the frame was decoded and is available through image()
+        /// @retval 1 the frame references a frame that was not decoded, a keyframe is required
+        /// @retval -1 the packet is invalid
+        int decode(const void* data, size_t size)
+        {
+            auto p = static_cast<const uint8_t*>(data);
+            if (!p || size < delta::HeaderSize || p[0] != delta::Magic || p[1] > delta::DeltaFrame)
+                return -1;
+
+            const bool key = (p[1] == delta::KeyFrame);
+            const int width = static_cast<int>(delta::get16(p + 2)), height = static_cast<int>(delta::get16(p + 4));
+            const uint32_t seq = delta::get32(p + 8), ref = delta::get32(p + 12);
+            if (!width || !height)
+                return -1;
+            if (!key && (!valid_ || ref != seq_ || width != width_ || height != height_))
+            {
+                valid_ = false;
+                return 1;
+            }
+
+            // every block takes at least its 3 bit code, which bounds the dimensions a packet can describe before allocating
+            const size_t n = static_cast<size_t>(width) * height;
+            if (((n + delta::BlockSize - 1) / delta::BlockSize) * 3 > (size - delta::HeaderSize) * 8)
+            {
+                valid_ = false;
+                return -1;
+            }
+            img_.resize(n);
+            delta::BitReader br(p + delta::HeaderSize, size - delta::HeaderSize);
+            uint8_t* img = img_.data();
+
+            size_t i = 0;
+            int x = 0, y = 0;
+            for (size_t b = 0; b < n; b += delta::BlockSize)
+            {
+                const size_t e = (b + delta::BlockSize < n) ? b + delta::BlockSize : n;
+                const uint32_t k = br.read(3);
+                for (i = b; i < e; i++)
+                {
+                    uint32_t u = 0;
+                    if (k != delta::ZeroBlock)
+                    {
+                        auto q = static_cast<uint32_t>(delta::leadingOnes(br.peek()));
+                        if (q < delta::Escape)
+                        {
+                            br.skip(static_cast<int>(q) + 1);
+                            u = (q << k) | br.read(static_cast<int>(k));
+                        }
+                        else
+                        {
+                            br.skip(delta::Escape);
+                            u = br.read(8);
+                        }
+                    }
+                    const uint8_t r = delta::unzigzag(u);
+                    // delta frames decode in place over the previous frame
+                    img[i] = static_cast<uint8_t>(r + (key ? delta::predict(img, i, x, y, width) : img[i]));
+                    if (++x == width)
+                    {
+                        x = 0;
+                        y++;
+                    }
+                }
+                if (br.overrun())
+                {
+                    valid_ = false;
+                    return -1;
+                }
+            }
+
+            seq_ = seq;
+            width_ = width;
+            height_ = height;
+            valid_ = true;
+            return 0;
+        }
+
+        /// @return the last decoded image
+        const uint8_t* image() const { return img_.data(); }
+        /// @return the width of the last decoded image
+        int width() const { return width_; }
+        /// @return the height of the last decoded image
+        int height() const { return height_; }
+
+    private:
+        uint32_t seq_;              ///< sequence number of the last decoded frame
+        int width_;                 ///< width of the last decoded frame
+        int height_;                ///< height of the last decoded frame
+        bool valid_;                ///< flag if the last decoded frame can be referenced
+        std::vector<uint8_t> img_;  ///< decoded image, also the reference for the next delta frame
+    };
+}
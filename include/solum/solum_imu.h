@@ -0,0 +1,281 @@
+#pragma once
+
+#include "solum_def.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/// imu to frame time alignment
+///
+/// buffers imu samples, arriving either through the imu data callback or along with the frames, and interpolates the
+/// pose for any frame timestamp: orientation through spherical linear interpolation of the quaternions, the raw sensor
+/// values linearly. sample timestamps are corrected by a clock offset and a latency before the lookup, such that a
+/// calibrated delay between the imu and the image acquisition is compensated.
+///
+/// the buffer is a ring of fixed capacity written by a single thread and read by any number of threads without locking,
+/// each slot being guarded by a sequence number that readers check before and after copying the sample. as the two
+/// callbacks are not guaranteed to run on the same thread, a buffer is fed from one source only.
+namespace solum
+{
+    namespace imu
+    {
+        /// interpolates two unit quaternions along the shortest arc
+        /// @param[in] a the first quaternion (w, x, y, z)
+        /// @param[in] b the second quaternion (w, x, y, z)
+        /// @param[in] t the interpolation factor (0 - 1)
+        /// @param[out] out holds the normalized result (w, x, y, z)
+        inline void slerp(const double a[4], const double b[4], double t, double out[4])
+        {
+            double d = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+            // q and -q are the same rotation, take the shorter way round
+            const double sign = (d < 0) ? -1.0 : 1.0;
+            d *= sign;
+
+            double wa = 1.0 - t, wb = t;
+            // close quaternions interpolate linearly, avoiding the division by a vanishing sine
+            if (d < 0.9995)
+            {
+                const double theta = std::acos(d), s = std::sin(theta);
+                wa = std::sin((1.0 - t) * theta) / s;
+                wb = std::sin(t * theta) / s;
+            }
+            wb *= sign;
+
+            double n = 0;
+            for (int i = 0; i < 4; i++)
+            {
+                out[i] = wa * a[i] + wb * b[i];
+                n += out[i] * out[i];
+            }
+            n = (n > 0) ? 1.0 / std::sqrt(n) : 0.0;
+            for (int i = 0; i < 4; i++)
+                out[i] *= n;
+        }
+    }
+
+    /// lock-free buffer of imu samples with pose interpolation
+    class ImuBuffer
+    {
+    public:
+        /// default constructor
+        /// @param[in] capacity the number of samples kept, rounded up to a power of two
+        explicit ImuBuffer(size_t capacity = 1024) : mask_(0), head_(0), base_(0), last_(0), offset_(0), latency_(0), tolerance_(5000000)
+        {
+            size_t n = 2;
+            while (n < capacity)
+                n <<= 1;
+            mask_ = n - 1;
+            slots_.reset(new Slot[n]);
+            for (size_t i = 0; i < n; i++)
+                slots_[i].seq.store(0, std::memory_order_relaxed);
+        }
+
+        ImuBuffer(const ImuBuffer&) = delete;
+        ImuBuffer& operator=(const ImuBuffer&) = delete;
+
+        /// sets the offset of the frame clock relative to the imu clock, added to sample timestamps
+        /// @param[in] ns the offset in nanoseconds
+        void setClockOffset(long long int ns) { offset_.store(ns, std::memory_order_relaxed); }
+        /// sets the delay of the imu samples relative to the image acquisition, subtracted from sample timestamps
+        /// @param[in] ns the latency in nanoseconds
+        void setLatency(long long int ns) { latency_.store(ns, std::memory_order_relaxed); }
+        /// sets how far beyond the buffered samples a lookup is answered with the nearest sample rather than failing
+        /// @param[in] ns the tolerance in nanoseconds, 5 ms by default
+        void setTolerance(long long int ns) { tolerance_.store(ns, std::memory_order_relaxed); }
+
+        /// adds a sample
+        /// @param[in] pos the sample
+        /// @return true if the sample was added, false if it was not newer than the latest sample, i.e. a repeat
+        /// @note samples must be added from a single thread, thus from either the imu data callback or the frame callbacks
+        bool push(const CusPosInfo& pos)
+        {
+            const uint64_t n = head_.load(std::memory_order_relaxed);
+            if (n > base_.load(std::memory_order_relaxed) && pos.tm <= last_)
+                return false;
+
+            Slot& s = slots_[n & mask_];
+            s.seq.store(2 * n + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            s.tm.store(pos.tm, std::memory_order_relaxed);
+            const double v[Values] = { pos.gx, pos.gy, pos.gz, pos.ax, pos.ay, pos.az, pos.mx, pos.my, pos.mz, pos.qw, pos.qx, pos.qy, pos.qz };
+            for (int i = 0; i < Values; i++)
+                s.v[i].store(v[i], std::memory_order_relaxed);
+            s.seq.store(2 * n + 2, std::memory_order_release);
+
+            last_ = pos.tm;
+            head_.store(n + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// adds the samples supplied along with a frame, skipping those already added
+        /// @param[in] pos the samples
+        /// @param[in] npos the number of samples
+        void push(const CusPosInfo* pos, int npos)
+        {
+            for (int i = 0; pos && i < npos; i++)
+                push(pos[i]);
+        }
+
+        /// discards all samples
+        /// @note must be called from the thread adding samples
+        void clear() { base_.store(head_.load(std::memory_order_relaxed), std::memory_order_release); }
+
+        /// @return the number of samples available
+        size_t size() const
+        {
+            const uint64_t h = head_.load(std::memory_order_acquire), b = oldest(h);
+            return static_cast<size_t>(h - b);
+        }
+
+        /// retrieves the latest sample
+        /// @param[out] out holds the sample, its timestamp corrected by the clock offset and latency
+        /// @return success of the call, fails if no samples were added
+        bool latest(CusPosInfo& out) const
+        {
+            const uint64_t h = head_.load(std::memory_order_acquire);
+            if (h == oldest(h) || !read(h - 1, out))
+                return false;
+            out.tm += correction();
+            return true;
+        }
+
+        /// interpolates the pose at a timestamp
+        /// @param[in] tm the timestamp in nanoseconds, i.e. the timestamp of a frame
+        /// @param[out] out holds the interpolated sample, stamped with the requested timestamp
+        /// @return success of the call, fails if the timestamp lies outside of the buffered samples by more than the tolerance
+        bool pose(long long int tm, CusPosInfo& out) const
+        {
+            // a writer may overwrite the oldest samples while searching, in which case the search starts over
+            for (int attempt = 0; attempt < 4; attempt++)
+            {
+                const int res = find(tm, out);
+                if (res >= 0)
+                    return (res == 1);
+            }
+            return false;
+        }
+
+    private:
+        static constexpr int Values = 13;   ///< values per sample besides the timestamp
+
+        /// ring slot
+        struct Slot
+        {
+            std::atomic<uint64_t> seq;          ///< 2 * n + 2 once sample n is stored, odd while being written
+            std::atomic<long long int> tm;      ///< timestamp
+            std::atomic<double> v[Values];      ///< gyroscope, accelerometer, magnetometer and quaternion values
+        };
+
+        /// @return the correction applied to sample timestamps
+        long long int correction() const { return offset_.load(std::memory_order_relaxed) - latency_.load(std::memory_order_relaxed); }
+
+        /// @param[in] h the current head
+        /// @return the index of the oldest sample available
+        uint64_t oldest(uint64_t h) const
+        {
+            const uint64_t b = base_.load(std::memory_order_acquire), cap = mask_ + 1;
+            // the slot after the oldest is kept as a margin against the writer lapping a reader
+            return (h > cap - 1 && h - (cap - 1) > b) ? h - (cap - 1) : b;
+        }
+
+        /// reads a sample
+        /// @param[in] n the index of the sample
+        /// @param[out] out holds the sample
+        /// @return success of the call, fails if the slot was overwritten
+        bool read(uint64_t n, CusPosInfo& out) const
+        {
+            const Slot& s = slots_[n & mask_];
+            const uint64_t seq = s.seq.load(std::memory_order_acquire);
+            if (seq != 2 * n + 2)
+                return false;
+            out.tm = s.tm.load(std::memory_order_relaxed);
+            double v[Values];
+            for (int i = 0; i < Values; i++)
+                v[i] = s.v[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s.seq.load(std::memory_order_relaxed) != seq)
+                return false;
+            out.gx = v[0]; out.gy = v[1]; out.gz = v[2];
+            out.ax = v[3]; out.ay = v[4]; out.az = v[5];
+            out.mx = v[6]; out.my = v[7]; out.mz = v[8];
+            out.qw = v[9]; out.qx = v[10]; out.qy = v[11]; out.qz = v[12];
+            return true;
+        }
+
+        /// looks up and interpolates the pose at a timestamp
+        /// @param[in] tm the timestamp
+        /// @param[out] out holds the interpolated sample
+        /// @return 1 on success, 0 if the timestamp is out of range, -1 if a sample was overwritten during the lookup
+        int find(long long int tm, CusPosInfo& out) const
+        {
+            const uint64_t h = head_.load(std::memory_order_acquire);
+            uint64_t lo = oldest(h);
+            if (h == lo)
+                return 0;
+
+            const long long int corr = correction(), tol = tolerance_.load(std::memory_order_relaxed);
+            CusPosInfo a, b;
+            if (!read(h - 1, b))
+                return -1;
+            if (tm >= b.tm + corr)
+            {
+                if (tm - (b.tm + corr) > tol)
+                    return 0;
+                out = b;
+                out.tm = tm;
+                return 1;
+            }
+            if (!read(lo, a))
+                return -1;
+            if (tm < a.tm + corr)
+            {
+                if ((a.tm + corr) - tm > tol)
+                    return 0;
+                out = a;
+                out.tm = tm;
+                return 1;
+            }
+
+            // find the last sample at or before the timestamp, samples being ordered by time
+            uint64_t hi = h - 1;
+            while (hi - lo > 1)
+            {
+                const uint64_t mid = lo + (hi - lo) / 2;
+                CusPosInfo m;
+                if (!read(mid, m))
+                    return -1;
+                if (m.tm + corr <= tm)
+                    lo = mid;
+                else
+                    hi = mid;
+            }
+            if (!read(lo, a) || !read(hi, b))
+                return -1;
+
+            const double t = (b.tm > a.tm) ? static_cast<double>(tm - (a.tm + corr)) / static_cast<double>(b.tm - a.tm) : 0.0;
+            auto lerp = [t](double x, double y) { return x + (y - x) * t; };
+            out.tm = tm;
+            out.gx = lerp(a.gx, b.gx); out.gy = lerp(a.gy, b.gy); out.gz = lerp(a.gz, b.gz);
+            out.ax = lerp(a.ax, b.ax); out.ay = lerp(a.ay, b.ay); out.az = lerp(a.az, b.az);
+            out.mx = lerp(a.mx, b.mx); out.my = lerp(a.my, b.my); out.mz = lerp(a.mz, b.mz);
+            const double qa[4] = { a.qw, a.qx, a.qy, a.qz }, qb[4] = { b.qw, b.qx, b.qy, b.qz };
+            double q[4];
+            imu::slerp(qa, qb, t, q);
+            out.qw = q[0]; out.qx = q[1]; out.qy = q[2]; out.qz = q[3];
+            return 1;
+        }
+
+    private:
+        std::unique_ptr<Slot[]> slots_;         ///< ring of samples
+        uint64_t mask_;                         ///< capacity - 1
+        std::atomic<uint64_t> head_;            ///< number of samples ever added
+        std::atomic<uint64_t> base_;            ///< index of the first sample since the last clear
+        long long int last_;                    ///< timestamp of the latest sample, only used by the writer
+        std::atomic<long long int> offset_;     ///< clock offset
+        std::atomic<long long int> latency_;    ///< imu latency
+        std::atomic<long long int> tolerance_;  ///< lookup tolerance
+    };
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <csetjmp>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <jpeglib.h>
+
+/// jpeg decoding for compressed processed and prescan images
+///
+/// wraps the libjpeg api, which libjpeg-turbo implements with simd kernels, keeping a single decompressor alive across
+/// frames and decoding straight into a buffer supplied by the caller, such that no allocation happens per frame.
+/// requires linking against libjpeg (ideally libjpeg-turbo, which also provides direct ARGB output).
+namespace solum
+{
+    /// reusable jpeg decoder
+    /// @note not thread safe, use one decoder per thread
+    class JpegDecoder
+    {
+    public:
+        /// output pixel formats
+        enum Output
+        {
+            Gray,   ///< 8 bit grayscale
+            Argb,   ///< 32 bit ARGB, matching the Uncompressed format
+        };
+
+        JpegDecoder()
+        {
+            std::memset(&dinfo_, 0, sizeof(dinfo_));
+            dinfo_.err = jpeg_std_error(&err_.mgr);
+            err_.mgr.error_exit = errorExit;
+            err_.mgr.output_message = outputMessage;
+            jpeg_create_decompress(&dinfo_);
+        }
+        ~JpegDecoder() { jpeg_destroy_decompress(&dinfo_); }
+
+        JpegDecoder(const JpegDecoder&) = delete;
+        JpegDecoder& operator=(const JpegDecoder&) = delete;
+
+        /// reads the dimensions of a jpeg image
+        /// @param[in] data the compressed image
+        /// @param[in] size size of the compressed image in bytes
+        /// @param[out] width holds the width of the image
+        /// @param[out] height holds the height of the image
+        /// @return success of the call
+        bool dimensions(const void* data, size_t size, int& width, int& height)
+        {
+            if (!data || !size)
+                return false;
+            if (setjmp(err_.jump))
+            {
+                jpeg_abort_decompress(&dinfo_);
+                return false;
+            }
+            setSource(data, size);
+            jpeg_read_header(&dinfo_, TRUE);
+            width = static_cast<int>(dinfo_.image_width);
+            height = static_cast<int>(dinfo_.image_height);
+            jpeg_abort_decompress(&dinfo_);
+            return true;
+        }
+
+        /// decodes a jpeg image into a caller supplied buffer
+        /// @param[in] data the compressed image
+        /// @param[in] size size of the compressed image in bytes
+        /// @param[out] out the buffer to decode into
+        /// @param[in] width the expected width of the image
+        /// @param[in] height the expected height of the image
+        /// @param[in] stride the number of bytes between rows of the output buffer
+        /// @param[in] format the output pixel format
+        /// @return success of the call, fails if the image does not match the expected dimensions
+        bool decode(const void* data, size_t size, void* out, int width, int height, size_t stride, Output format)
+        {
+            if (!data || !size || !out)
+                return false;
+            if (setjmp(err_.jump))
+            {
+                jpeg_abort_decompress(&dinfo_);
+                return false;
+            }
+
+            setSource(data, size);
+            jpeg_read_header(&dinfo_, TRUE);
+            if (static_cast<int>(dinfo_.image_width) != width || static_cast<int>(dinfo_.image_height) != height)
+            {
+                jpeg_abort_decompress(&dinfo_);
+                return false;
+            }
+
+#ifdef JCS_EXTENSIONS
+            dinfo_.out_color_space = (format == Gray) ? JCS_GRAYSCALE : JCS_EXT_BGRA;
+#else
+            dinfo_.out_color_space = (format == Gray) ? JCS_GRAYSCALE : JCS_RGB;
+#endif
+            jpeg_start_decompress(&dinfo_);
+
+            auto dst = static_cast<uint8_t*>(out);
+            JSAMPROW row;
+            while (dinfo_.output_scanline < dinfo_.output_height)
+            {
+                auto line = dst + static_cast<size_t>(dinfo_.output_scanline) * stride;
+#ifdef JCS_EXTENSIONS
+                row = line;
+                jpeg_read_scanlines(&dinfo_, &row, 1);
+#else
+                if (format == Gray)
+                {
+                    row = line;
+                    jpeg_read_scanlines(&dinfo_, &row, 1);
+                }
+                else
+                {
+                    // expand rgb to ARGB when the library lacks extended color spaces
+                    rgb_.resize(static_cast<size_t>(width) * 3);
+                    row = rgb_.data();
+                    jpeg_read_scanlines(&dinfo_, &row, 1);
+                    for (int x = 0; x < width; x++)
+                    {
+                        line[x * 4 + 0] = rgb_[x * 3 + 2];
+                        line[x * 4 + 1] = rgb_[x * 3 + 1];
+                        line[x * 4 + 2] = rgb_[x * 3 + 0];
+                        line[x * 4 + 3] = 0xff;
+                    }
+                }
+#endif
+            }
+
+            jpeg_finish_decompress(&dinfo_);
+            return true;
+        }
+
+    private:
+        /// error manager that returns control to the decoder instead of exiting
+        struct ErrorManager
+        {
+            jpeg_error_mgr mgr;     ///< libjpeg error manager
+            std::jmp_buf jump;      ///< return point
+        };
+
+        /// called by libjpeg on fatal errors
+        /// @param[in] info the decompressor
+        static void errorExit(j_common_ptr info)
+        {
+            std::longjmp(reinterpret_cast<ErrorManager*>(info->err)->jump, 1);
+        }
+
+        /// called by libjpeg to print messages, which are suppressed
+        static void outputMessage(j_common_ptr) { }
+
+        /// points the decompressor at the compressed data
+        /// @param[in] data the compressed data
+        /// @param[in] size the size of the data
+        void setSource(const void* data, size_t size)
+        {
+            // libjpeg 8 takes a non-const buffer, which it only ever reads, whereas libjpeg-turbo takes a const one
+            jpeg_mem_src(&dinfo_, const_cast<unsigned char*>(static_cast<const unsigned char*>(data)), static_cast<unsigned long>(size));
+        }
+
+    private:
+        jpeg_decompress_struct dinfo_;  ///< the reused decompressor
+        ErrorManager err_;              ///< error handling
+        std::vector<uint8_t> rgb_;      ///< row buffer for expanding rgb output
+    };
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace solum
+{
+    /// lock-free "latest value" mailbox built on a triple buffer
+    ///
+    /// designed for a single producer (typically an api callback) and a single consumer (typically a display),
+    /// the producer always has a slot to write into without waiting, and the consumer always reads the newest
+    /// complete value, never one that is being written. values that are replaced before the consumer gets to them
+    /// are counted as dropped.
+    ///
+    /// slots are recycled rather than cleared, thus a slot handed out by back() still holds whatever value it
+    /// carried previously, which allows resources held by a value (i.e. a frame lease) to be released before reuse.
+    template <typename T>
+    class Mailbox
+    {
+    public:
+        /// default constructor
+        Mailbox() : state_(1), back_(0), front_(2), published_(0), dropped_(0) { }
+
+        Mailbox(const Mailbox&) = delete;
+        Mailbox& operator=(const Mailbox&) = delete;
+
+        /// retrieves the slot to write the next value into
+        /// @return the producer's slot
+        /// @note producer only
+        T& back() { return slots_[back_]; }
+
+        /// publishes the value written into the back slot, making it the latest value
+        /// @return true if the previously published value was never consumed, and thus was dropped
+        /// @note producer only
+        bool publish()
+        {
+            auto prev = state_.exchange(static_cast<uint8_t>(back_ | Fresh), std::memory_order_acq_rel);
+            back_ = prev & Index;
+            published_.fetch_add(1, std::memory_order_relaxed);
+            if (prev & Fresh)
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            return false;
+        }
+
+        /// swaps in the latest published value if there is one
+        /// @return true if front() now holds a value that was not seen before
+        /// @note consumer only
+        bool update()
+        {
+            if (!(state_.load(std::memory_order_acquire) & Fresh))
+                return false;
+            auto prev = state_.exchange(front_, std::memory_order_acq_rel);
+            front_ = prev & Index;
+            return true;
+        }
+
+        /// retrieves the latest value obtained through update()
+        /// @return the consumer's slot
+        /// @note consumer only
+        T& front() { return slots_[front_]; }
+
+        /// retrieves one of the three slots regardless of ownership
+        /// @param[in] i the slot index (0 - 2)
+        /// @return the slot
+        /// @note only safe once the producer has stopped, for example to release resources held by the values
+        T& slot(int i) { return slots_[i]; }
+
+        /// @return the total number of values published
+        uint64_t published() const { return published_.load(std::memory_order_relaxed); }
+        /// @return the total number of values replaced before being consumed
+        uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    private:
+        static constexpr uint8_t Index = 0x03;  ///< mask for the middle slot index
+        static constexpr uint8_t Fresh = 0x04;  ///< flag set when the middle slot holds an unconsumed value
+
+        T slots_[3];                            ///< the triple buffer
+        std::atomic<uint8_t> state_;            ///< index of the middle slot along with the fresh flag
+        alignas(64) uint8_t back_;              ///< index of the producer's slot
+        alignas(64) uint8_t front_;             ///< index of the consumer's slot
+        std::atomic<uint64_t> published_;       ///< total values published
+        std::atomic<uint64_t> dropped_;         ///< total values dropped
+    };
+}
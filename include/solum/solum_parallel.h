@@ -0,0 +1,133 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// data parallel helpers for the client side processing modules
+namespace solum
+{
+    /// persistent pool of worker threads running loops in parallel, the calling thread takes part in each loop such
+    /// that a pool of a single thread runs loops inline
+    class ThreadPool
+    {
+    public:
+        /// default constructor
+        /// @param[in] threads the number of threads including the caller, 0 to use the number of hardware threads
+        explicit ThreadPool(int threads = 0) : generation_(0), active_(0), next_(0), count_(0), grain_(1), quit_(false)
+        {
+            if (threads <= 0)
+                threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+            for (int i = 1; i < threads; i++)
+                workers_.emplace_back([this, i] { run(i); });
+        }
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(lock_);
+                quit_ = true;
+            }
+            wake_.notify_all();
+            for (auto& w : workers_)
+                w.join();
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /// @return the number of threads taking part in a loop, i.e. the number of scratch buffers a loop may index
+        int size() const { return static_cast<int>(workers_.size()) + 1; }
+
+        /// runs a loop in parallel, returning once all iterations completed
+        /// @param[in] n the number of iterations
+        /// @param[in] fn the loop body, called as fn(begin, end, worker) for consecutive ranges of iterations, where
+        ///               worker (0 - size() - 1) is unique among the concurrent calls
+        /// @note loops from different threads are serialized, and a loop body may not start another loop on the same pool
+        template <class F> void parallelFor(size_t n, F&& fn)
+        {
+            if (!n)
+                return;
+            std::lock_guard<std::mutex> serial(serial_);
+            if (workers_.empty() || n == 1)
+            {
+                fn(static_cast<size_t>(0), n, 0);
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(lock_);
+                job_ = [&fn](size_t b, size_t e, int w) { fn(b, e, w); };
+                count_ = n;
+                // a few ranges per thread balance uneven work without much contention on the counter
+                grain_ = std::max<size_t>(1, n / (static_cast<size_t>(size()) * 4));
+                next_.store(0);
+                active_ = static_cast<int>(workers_.size());
+                generation_++;
+            }
+            wake_.notify_all();
+
+            work(0);
+
+            std::unique_lock<std::mutex> lock(lock_);
+            done_.wait(lock, [this] { return active_ == 0; });
+            job_ = nullptr;
+        }
+
+    private:
+        /// takes ranges off the current loop until it is exhausted
+        /// @param[in] worker the index of the calling thread
+        void work(int worker)
+        {
+            for (;;)
+            {
+                const size_t b = next_.fetch_add(grain_);
+                if (b >= count_)
+                    break;
+                job_(b, std::min(b + grain_, count_), worker);
+            }
+        }
+
+        /// worker thread
+        /// @param[in] worker the index of the worker
+        void run(int worker)
+        {
+            unsigned long long seen = 0;
+            for (;;)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(lock_);
+                    wake_.wait(lock, [&] { return quit_ || generation_ != seen; });
+                    if (quit_)
+                        return;
+                    seen = generation_;
+                }
+
+                work(worker);
+
+                std::lock_guard<std::mutex> lock(lock_);
+                if (--active_ == 0)
+                    done_.notify_one();
+            }
+        }
+
+    private:
+        std::vector<std::thread> workers_;  ///< worker threads, excluding the caller
+        std::mutex serial_;                 ///< serializes loops
+        std::mutex lock_;                   ///< protects the loop state
+        std::condition_variable wake_;      ///< signals a new loop or shutdown to the workers
+        std::condition_variable done_;      ///< signals that all workers finished the loop
+        std::function<void(size_t, size_t, int)> job_; ///< current loop body
+        unsigned long long generation_;     ///< loop counter, used to wake the workers once per loop
+        int active_;                        ///< number of workers yet to finish the loop
+        std::atomic<size_t> next_;          ///< next iteration to hand out
+        size_t count_;                      ///< number of iterations in the loop
+        size_t grain_;                      ///< iterations handed out at once
+        bool quit_;                         ///< shutdown flag
+    };
+}
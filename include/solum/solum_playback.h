@@ -0,0 +1,184 @@
+#pragma once
+
+#include "solum.h"
+#include "solum_record.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+
+namespace solum
+{
+    /// replays a recorded session through the regular callbacks
+    ///
+    /// frames are delivered on a dedicated thread in the order they were recorded, to the same callbacks that are
+    /// provided to solumInit(), along with CusInitParams::userData, which allows the downstream pipeline to be driven
+    /// without a probe. pacing follows the recorded timestamps, scaled by the rate, or is disabled entirely to measure
+    /// the throughput of the pipeline. images are delivered from the mapped recording, thus leased frames are not
+    /// supported and CusInitParams::newFrameFn is never called.
+    class Playback
+    {
+    public:
+        Playback() : params_(), rate_(1.0), loop_(false), running_(false), stop_(false), played_(0), elapsed_(0) { }
+        ~Playback() { stop(); }
+
+        Playback(const Playback&) = delete;
+        Playback& operator=(const Playback&) = delete;
+
+        /// opens a recording
+        /// @param[in] path the file path
+        /// @return success of the call
+        bool open(const std::string& path)
+        {
+            stop();
+            return reader_.open(path) && reader_.count() > 0;
+        }
+
+        /// starts playback
+        /// @param[in] params the callbacks to drive, only the callbacks and user data are used
+        /// @param[in] rate the playback rate relative to real-time (i.e. 2 for double speed), 0 or less to play as fast as possible
+        /// @param[in] loop flag to restart from the beginning once the end of the recording is reached
+        /// @return success of the call
+        bool start(const CusInitParams& params, double rate = 1.0, bool loop = false)
+        {
+            stop();
+            if (!reader_.count())
+                return false;
+            params_ = params;
+            rate_ = rate;
+            loop_ = loop;
+            stop_ = false;
+            played_ = 0;
+            elapsed_ = 0;
+            running_ = true;
+            thread_ = std::thread(&Playback::run, this);
+            return true;
+        }
+
+        /// stops playback and waits for the playback thread to exit
+        void stop()
+        {
+            {
+                std::lock_guard<std::mutex> lock(lock_);
+                stop_ = true;
+            }
+            wake_.notify_all();
+            if (thread_.joinable())
+                thread_.join();
+        }
+
+        /// waits for playback to reach the end of the recording
+        /// @note never returns for looped playback unless stop() is called from another thread
+        void wait()
+        {
+            if (thread_.joinable())
+                thread_.join();
+        }
+
+        /// @return true while frames are being delivered
+        bool running() const { return running_; }
+        /// @return the number of chunks delivered since playback started
+        uint64_t played() const { return played_; }
+        /// @return the wall clock time spent delivering frames in seconds
+        double elapsed() const { return elapsed_; }
+        /// @return the recording being played
+        const RecordReader& reader() const { return reader_; }
+
+    private:
+        /// delivers a chunk to the matching callback
+        /// @param[in] frame the recorded chunk
+        void deliver(const RecordedFrame& frame)
+        {
+            auto user = params_.userData;
+            switch (frame.stream)
+            {
+            case RecordProcessed:
+                if (params_.newProcessedImageFn)
+                    params_.newProcessedImageFn(frame.data, frame.processed(), frame.npos, frame.pos, user);
+                break;
+            case RecordRaw:
+                if (params_.newRawImageFn)
+                    params_.newRawImageFn(frame.data, frame.raw(), frame.npos, frame.pos, user);
+                break;
+            case RecordSpectral:
+                if (params_.newSpectralImageFn)
+                    params_.newSpectralImageFn(frame.data, frame.spectral(), user);
+                break;
+            case RecordImu:
+                if (params_.newImuDataFn && frame.npos)
+                    params_.newImuDataFn(frame.pos, user);
+                break;
+            default: break;
+            }
+        }
+
+        /// waits until a point in time or until playback is stopped
+        /// @param[in] tm the point in time
+        /// @return false if playback was stopped
+        bool sleepUntil(std::chrono::steady_clock::time_point tm)
+        {
+            std::unique_lock<std::mutex> lock(lock_);
+            return !wake_.wait_until(lock, tm, [this] { return stop_.load(); });
+        }
+
+        /// playback thread
+        void run()
+        {
+            using clock = std::chrono::steady_clock;
+            auto begin = clock::now();
+            RecordedFrame frame;
+
+            if (params_.imagingFn)
+                params_.imagingFn(ImagingReady, 1, params_.userData);
+
+            do
+            {
+                auto start = clock::now();
+                long long int base = 0, last = 0;
+                bool first = true;
+                for (size_t i = 0; i < reader_.count(); i++)
+                {
+                    if (stop_)
+                        break;
+                    if (!reader_.frame(i, frame))
+                        continue;
+                    // pace relative to the first chunk that could be read, which need not be the first chunk
+                    if (first)
+                    {
+                        base = last = frame.tm;
+                        first = false;
+                    }
+                    // timestamps of different streams may interleave slightly, never schedule backwards
+                    last = std::max(last, frame.tm);
+                    if (rate_ > 0)
+                    {
+                        auto offset = std::chrono::nanoseconds(static_cast<long long int>(static_cast<double>(last - base) / rate_));
+                        if (!sleepUntil(start + std::chrono::duration_cast<clock::duration>(offset)))
+                            break;
+                    }
+                    deliver(frame);
+                    played_++;
+                }
+            }
+            while (loop_ && !stop_);
+
+            elapsed_ = std::chrono::duration<double>(clock::now() - begin).count();
+            if (params_.imagingFn)
+                params_.imagingFn(ImagingReady, 0, params_.userData);
+            running_ = false;
+        }
+
+    private:
+        RecordReader reader_;               ///< the recording
+        CusInitParams params_;              ///< callbacks to drive
+        double rate_;                       ///< playback rate, 0 or less for unpaced playback
+        bool loop_;                         ///< loop flag
+        std::atomic_bool running_;          ///< set while the playback thread delivers frames
+        std::atomic_bool stop_;             ///< stop request, set under the lock
+        std::atomic<uint64_t> played_;      ///< chunks delivered
+        std::atomic<double> elapsed_;       ///< wall clock time of the last playback
+        std::thread thread_;                ///< playback thread
+        std::mutex lock_;                   ///< protects the stop request
+        std::condition_variable wake_;      ///< wakes the playback thread when stopping
+    };
+}
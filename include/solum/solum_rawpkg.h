@@ -0,0 +1,661 @@
+#pragma once
+
+#include "solum_parallel.h"
+#include "solum_record.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/// raw data package reader
+///
+/// reads the packages downloaded through solumReadRawData, a tar archive holding one .raw file per data type (b/envelope,
+/// iq or rf) along with metadata files, the .raw files being lzop compressed when the package was requested with lzo.
+/// compressed files are split into independently compressed blocks, which are decompressed in parallel on a thread pool
+/// straight into one buffer per file. frames are then indexed by timestamp and handed out as views into the package (or
+/// into the decompressed buffer), thus without copying.
+///
+/// raw file layout (little endian):
+///   id (4) | frames (4) | lines (4) | samples (4) | sample size (4) | frames * (timestamp (8) | lines * samples * sample size)
+namespace solum
+{
+    /// raw data types
+    enum RawType : int
+    {
+        RawB,       ///< envelope (b) data, suffixed _env
+        RawIq,      ///< iq data, suffixed _iq
+        RawRf,      ///< rf data, suffixed _rf
+        RawTypes
+    };
+
+    namespace rawpkg
+    {
+        /// @return the big endian 32 bit value at the pointer
+        inline uint32_t be32(const uint8_t* p) { return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3]; }
+        /// @return the big endian 16 bit value at the pointer
+        inline uint32_t be16(const uint8_t* p) { return (uint32_t(p[0]) << 8) | p[1]; }
+        /// @return the little endian 32 bit value at the pointer
+        inline uint32_t le32(const uint8_t* p) { return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24); }
+
+        /// calculates the adler32 checksum used by lzop
+        /// @param[in] adler the running checksum, 1 to start
+        /// @param[in] data the data
+        /// @param[in] size size of the data in bytes
+        /// @return the checksum
+        inline uint32_t adler32(uint32_t adler, const uint8_t* data, size_t size)
+        {
+            uint32_t a = adler & 0xffff, b = adler >> 16;
+            while (size)
+            {
+                // largest run before the sums may overflow
+                size_t n = std::min<size_t>(size, 5552);
+                size -= n;
+                while (n--)
+                {
+                    a += *data++;
+                    b += a;
+                }
+                a %= 65521;
+                b %= 65521;
+            }
+            return (b << 16) | a;
+        }
+
+        /// calculates the crc32 checksum (ieee 802.3)
+        /// @param[in] crc the running checksum, 0 to start
+        /// @param[in] data the data
+        /// @param[in] size size of the data in bytes
+        /// @return the checksum
+        inline uint32_t crc32(uint32_t crc, const uint8_t* data, size_t size)
+        {
+            struct Table
+            {
+                uint32_t v[256];
+                Table()
+                {
+                    for (uint32_t i = 0; i < 256; i++)
+                    {
+                        uint32_t c = i;
+                        for (int k = 0; k < 8; k++)
+                            c = (c & 1) ? (0xedb88320u ^ (c >> 1)) : (c >> 1);
+                        v[i] = c;
+                    }
+                }
+            };
+            static const Table table;
+            crc = ~crc;
+            for (size_t i = 0; i < size; i++)
+                crc = table.v[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+            return ~crc;
+        }
+
+        /// decompresses an lzo1x block, checking all bounds such that corrupt input fails rather than overruns
+        /// @param[in] src the compressed block
+        /// @param[in] srcSize size of the compressed block in bytes
+        /// @param[out] dst the output buffer
+        /// @param[in] dstSize size of the output buffer, the exact size of the decompressed block
+        /// @return success of the call
+        inline bool lzo1xDecompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize)
+        {
+            const uint8_t* ip = src;
+            const uint8_t* const ipEnd = src + srcSize;
+            uint8_t* op = dst;
+            uint8_t* const opEnd = dst + dstSize;
+
+            auto literals = [&](size_t n) -> bool
+            {
+                if (static_cast<size_t>(ipEnd - ip) < n || static_cast<size_t>(opEnd - op) < n)
+                    return false;
+                std::memcpy(op, ip, n);
+                op += n;
+                ip += n;
+                return true;
+            };
+            // extended lengths add 255 per zero byte followed by the final byte
+            auto extend = [&](size_t& n, size_t base) -> bool
+            {
+                while (ip < ipEnd && *ip == 0)
+                {
+                    n += 255;
+                    ip++;
+                }
+                if (ip >= ipEnd)
+                    return false;
+                n += base + *ip++;
+                return true;
+            };
+
+            if (ip >= ipEnd)
+                return false;
+
+            // the state tells how instructions below 16 are interpreted: 0 after a match without trailing literals (a literal
+            // run), 1 - 3 after a match with trailing literals (a 2 byte match), 4 after a literal run (a 3 byte match)
+            size_t state = 0;
+            if (*ip > 17)
+            {
+                const size_t t = *ip++ - 17u;
+                if (!literals(t))
+                    return false;
+                state = (t < 4) ? t : 4;
+            }
+
+            for (;;)
+            {
+                if (ip >= ipEnd)
+                    return false;
+                size_t t = *ip++, len, dist, trailing;
+                if (t < 16)
+                {
+                    if (state == 0)
+                    {
+                        if (t == 0 && !extend(t, 15))
+                            return false;
+                        if (!literals(t + 3))
+                            return false;
+                        state = 4;
+                        continue;
+                    }
+                    if (ip >= ipEnd)
+                        return false;
+                    len = (state == 4) ? 3 : 2;
+                    dist = 1 + (t >> 2) + (static_cast<size_t>(*ip++) << 2) + ((state == 4) ? 0x800 : 0);
+                    trailing = t & 3;
+                }
+                else if (t >= 64)
+                {
+                    if (ip >= ipEnd)
+                        return false;
+                    len = (t >> 5) + 1;
+                    dist = 1 + ((t >> 2) & 7) + (static_cast<size_t>(*ip++) << 3);
+                    trailing = t & 3;
+                }
+                else
+                {
+                    const bool far = (t < 32);
+                    len = far ? (t & 7) : (t & 31);
+                    if (len == 0 && !extend(len, far ? 7 : 31))
+                        return false;
+                    len += 2;
+                    if (ipEnd - ip < 2)
+                        return false;
+                    dist = (ip[0] >> 2) + (static_cast<size_t>(ip[1]) << 6);
+                    trailing = ip[0] & 3;
+                    ip += 2;
+                    if (far)
+                    {
+                        dist += (t & 8) << 11;
+                        // a zero distance marks the end of the stream
+                        if (dist == 0)
+                            return (op == opEnd && ip == ipEnd);
+                        dist += 0x4000;
+                    }
+                    else
+                        dist += 1;
+                }
+
+                if (dist > static_cast<size_t>(op - dst) || static_cast<size_t>(opEnd - op) < len)
+                    return false;
+                const uint8_t* m = op - dist;
+                if (dist >= len)
+                    std::memcpy(op, m, len);
+                else
+                {
+                    // overlapping matches repeat the last dist bytes
+                    for (size_t i = 0; i < len; i++)
+                        op[i] = m[i];
+                }
+                op += len;
+
+                if (!literals(trailing))
+                    return false;
+                state = trailing;
+            }
+        }
+
+        /// block of an lzop file
+        struct LzopBlock
+        {
+            const uint8_t* src;     ///< compressed data, stored verbatim when as large as the decompressed data
+            size_t srcSize;         ///< size of the compressed data
+            size_t dstOffset;       ///< offset of the decompressed data within the file
+            size_t dstSize;         ///< size of the decompressed data
+            uint32_t check;         ///< checksum of the decompressed data
+            int checkType;          ///< 0 for no checksum, 1 for adler32, 2 for crc32
+        };
+
+        /// parses the headers of an lzop file
+        /// @param[in] data the file
+        /// @param[in] size size of the file in bytes
+        /// @param[out] blocks holds the blocks of the file
+        /// @param[out] total holds the decompressed size
+        /// @return success of the call, fails for anything but lzo1x methods
+        inline bool parseLzop(const uint8_t* data, size_t size, std::vector<LzopBlock>& blocks, size_t& total)
+        {
+            static const uint8_t magic[9] = { 0x89, 'L', 'Z', 'O', 0x00, '\r', '\n', 0x1a, '\n' };
+            enum : uint32_t
+            {
+                AdlerD = 0x1, AdlerC = 0x2, ExtraField = 0x40, CrcD = 0x100, CrcC = 0x200, Filter = 0x800
+            };
+
+            blocks.clear();
+            total = 0;
+            size_t pos = 0;
+            auto need = [&](size_t n) { return pos <= size && size - pos >= n; };
+
+            if (!need(sizeof(magic) + 9) || std::memcmp(data, magic, sizeof(magic)))
+                return false;
+            pos += sizeof(magic);
+            const uint32_t version = be16(data + pos);
+            pos += 4;
+            if (version >= 0x0940)
+                pos += 2;
+            const uint8_t method = data[pos++];
+            if (version >= 0x0940)
+                pos++;
+            // methods 1 - 3 are lzo1x variants, which share the decompressor
+            if (method < 1 || method > 3 || !need(4))
+                return false;
+            const uint32_t flags = be32(data + pos);
+            pos += 4;
+            if (flags & Filter)
+                pos += 4;
+            pos += (version >= 0x0940) ? 12 : 8;
+            if (!need(1))
+                return false;
+            pos += 1 + data[pos];
+            pos += 4;
+            if (flags & ExtraField)
+            {
+                if (!need(4))
+                    return false;
+                pos += 8 + be32(data + pos);
+            }
+
+            for (;;)
+            {
+                if (!need(4))
+                    return false;
+                const size_t dst = be32(data + pos);
+                pos += 4;
+                if (!dst)
+                    return true;
+                if (!need(4))
+                    return false;
+                LzopBlock b;
+                b.srcSize = be32(data + pos);
+                pos += 4;
+                b.dstSize = dst;
+                b.dstOffset = total;
+                b.check = 0;
+                b.checkType = 0;
+                if (flags & (AdlerD | CrcD))
+                {
+                    if (!need(4))
+                        return false;
+                    b.check = be32(data + pos);
+                    b.checkType = (flags & AdlerD) ? 1 : 2;
+                    pos += ((flags & AdlerD) && (flags & CrcD)) ? 8 : 4;
+                }
+                if (b.srcSize < b.dstSize)
+                    pos += ((flags & AdlerC) ? 4 : 0) + ((flags & CrcC) ? 4 : 0);
+                if (b.srcSize > b.dstSize || !need(b.srcSize))
+                    return false;
+                b.src = data + pos;
+                pos += b.srcSize;
+                total += b.dstSize;
+                blocks.push_back(b);
+            }
+        }
+
+        /// header of a raw file
+        struct RawHeader
+        {
+            int32_t id;         ///< identifier
+            int32_t frames;     ///< number of frames
+            int32_t lines;      ///< lines per frame
+            int32_t samples;    ///< samples per line
+            int32_t sampleSize; ///< bytes per sample
+        };
+    }
+
+    /// view of a raw frame, pointing into the package or its decompressed data
+    struct RawFrame
+    {
+        RawType type;           ///< data type
+        long long int tm;       ///< timestamp in nanoseconds
+        int lines;              ///< number of lines
+        int samples;            ///< samples per line
+        int sampleSize;         ///< bytes per sample, i.e. 4 for iq pairs of 16 bit values
+        const void* data;       ///< frame data, lines * samples * sampleSize bytes stored line by line
+        size_t size;            ///< size of the frame data in bytes
+    };
+
+    /// file stored within a package, such as the metadata accompanying the raw data
+    struct RawPackageFile
+    {
+        std::string name;       ///< file name
+        const void* data;       ///< file contents
+        size_t size;            ///< size of the contents in bytes
+    };
+
+    /// reads and indexes raw data packages
+    class RawPackage
+    {
+    public:
+        /// default constructor
+        /// @param[in] threads the number of threads decompressing, 0 to use the number of hardware threads
+        explicit RawPackage(int threads = 0) : pool_(threads) { }
+
+        RawPackage(const RawPackage&) = delete;
+        RawPackage& operator=(const RawPackage&) = delete;
+
+        /// opens a package file, mapping it into memory
+        /// @param[in] path the package path
+        /// @param[in] verify flag to verify the checksums of compressed data
+        /// @return success of the call
+        bool open(const std::string& path, bool verify = false)
+        {
+            close();
+            if (!file_.open(path))
+                return false;
+            return load(file_.data(), file_.size(), verify);
+        }
+
+        /// opens a package held in memory, i.e. as downloaded through solumReadRawData
+        /// @param[in] data the package, which must outlive the reader
+        /// @param[in] size size of the package in bytes
+        /// @param[in] verify flag to verify the checksums of compressed data
+        /// @return success of the call
+        bool open(const void* data, size_t size, bool verify = false)
+        {
+            close();
+            return load(static_cast<const uint8_t*>(data), size, verify);
+        }
+
+        /// closes the package, invalidating all views
+        void close()
+        {
+            file_.close();
+            frames_.clear();
+            files_.clear();
+            buffers_.clear();
+            for (auto& t : types_)
+                t.clear();
+        }
+
+        /// @return the number of frames of all types
+        size_t count() const { return frames_.size(); }
+        /// @param[in] type the data type
+        /// @return the number of frames of the type
+        size_t count(RawType type) const { return (type >= 0 && type < RawTypes) ? types_[type].size() : 0; }
+
+        /// @param[in] i the frame index (0 - count() - 1), ordered by timestamp
+        /// @return the frame
+        const RawFrame& frame(size_t i) const { return frames_[i]; }
+        /// @param[in] type the data type
+        /// @param[in] i the frame index (0 - count(type) - 1), ordered by timestamp
+        /// @return the frame
+        const RawFrame& frame(RawType type, size_t i) const { return frames_[types_[type][i]]; }
+
+        /// finds the first frame of a type at or after a timestamp
+        /// @param[in] type the data type
+        /// @param[in] tm the timestamp in nanoseconds
+        /// @return the index of the frame within the type, count(type) if there is none
+        size_t seek(RawType type, long long int tm) const
+        {
+            if (type < 0 || type >= RawTypes)
+                return 0;
+            const auto& idx = types_[type];
+            auto it = std::lower_bound(idx.begin(), idx.end(), tm, [this](size_t i, long long int t) { return frames_[i].tm < t; });
+            return static_cast<size_t>(it - idx.begin());
+        }
+
+        /// @return the other files stored within the package
+        const std::vector<RawPackageFile>& files() const { return files_; }
+
+    private:
+        /// file entry of the tar archive
+        struct Entry
+        {
+            std::string name;       ///< file name
+            const uint8_t* data;    ///< contents
+            size_t size;            ///< size of the contents
+        };
+
+        /// @return the length of a string stored in a fixed size field, which may lack a terminator
+        static size_t fieldLength(const uint8_t* field, size_t size)
+        {
+            return static_cast<size_t>(std::find(field, field + size, 0) - field);
+        }
+
+        /// reads the entries of a tar archive
+        /// @param[in] data the archive
+        /// @param[in] size size of the archive
+        /// @param[out] entries holds the regular files of the archive
+        /// @return success of the call
+        static bool parseTar(const uint8_t* data, size_t size, std::vector<Entry>& entries)
+        {
+            std::string longName;
+            size_t pos = 0;
+            while (pos + 512 <= size)
+            {
+                const uint8_t* h = data + pos;
+                if (!h[0])
+                    return true;
+
+                size_t sz = 0;
+                for (int i = 124; i < 136 && h[i] >= '0' && h[i] <= '7'; i++)
+                    sz = (sz << 3) + static_cast<size_t>(h[i] - '0');
+                pos += 512;
+                if (pos + sz > size)
+                    return false;
+
+                const char type = static_cast<char>(h[156]);
+                if (type == 'L')
+                {
+                    // gnu long name preceding the entry it applies to
+                    longName.assign(reinterpret_cast<const char*>(data + pos), fieldLength(data + pos, sz));
+                }
+                else
+                {
+                    if (type == '0' || type == '\0')
+                    {
+                        std::string name;
+                        if (!longName.empty())
+                            name = longName;
+                        else
+                        {
+                            name.assign(reinterpret_cast<const char*>(h), fieldLength(h, 100));
+                            if (!std::memcmp(h + 257, "ustar", 5) && h[345])
+                                name = std::string(reinterpret_cast<const char*>(h + 345), fieldLength(h + 345, 155)) + "/" + name;
+                        }
+                        entries.push_back(Entry{ name, data + pos, sz });
+                    }
+                    longName.clear();
+                }
+                pos += (sz + 511) & ~static_cast<size_t>(511);
+            }
+            return true;
+        }
+
+        /// determines the data type of a raw file from its name
+        /// @param[in] name the file name
+        /// @param[out] lzo holds whether the file is lzop compressed
+        /// @return the data type, RawTypes if the file is not raw data
+        static RawType typeOf(const std::string& name, bool& lzo)
+        {
+            auto ends = [&](const char* s)
+            {
+                const size_t n = std::strlen(s);
+                return name.size() >= n && !name.compare(name.size() - n, n, s);
+            };
+            lzo = ends(".lzo");
+            const std::string base = lzo ? name.substr(0, name.size() - 4) : name;
+            auto baseEnds = [&](const char* s)
+            {
+                const size_t n = std::strlen(s);
+                return base.size() >= n && !base.compare(base.size() - n, n, s);
+            };
+            if (baseEnds("_env.raw"))
+                return RawB;
+            if (baseEnds("_iq.raw"))
+                return RawIq;
+            if (baseEnds("_rf.raw"))
+                return RawRf;
+            return RawTypes;
+        }
+
+        /// loads a package
+        /// @param[in] data the package
+        /// @param[in] size size of the package
+        /// @param[in] verify flag to verify checksums
+        /// @return success of the call
+        bool load(const uint8_t* data, size_t size, bool verify)
+        {
+            std::vector<Entry> entries;
+            if (!data || !parseTar(data, size, entries))
+            {
+                close();
+                return false;
+            }
+
+            // gather the blocks of all compressed files first, such that blocks of different files decompress concurrently
+            struct Raw
+            {
+                RawType type;
+                const uint8_t* data;
+                size_t size;
+                size_t buffer;
+            };
+            std::vector<Raw> raws;
+            std::vector<rawpkg::LzopBlock> blocks, all;
+            std::vector<std::pair<size_t, size_t>> work;
+            for (const auto& e : entries)
+            {
+                bool lzo = false;
+                const RawType type = typeOf(e.name, lzo);
+                if (type == RawTypes)
+                {
+                    files_.push_back(RawPackageFile{ e.name, e.data, e.size });
+                    continue;
+                }
+                if (!lzo)
+                {
+                    raws.push_back(Raw{ type, e.data, e.size, 0 });
+                    continue;
+                }
+
+                size_t total = 0;
+                if (!rawpkg::parseLzop(e.data, e.size, blocks, total))
+                {
+                    close();
+                    return false;
+                }
+                buffers_.emplace_back(total);
+                const size_t buffer = buffers_.size() - 1;
+                for (const auto& b : blocks)
+                {
+                    work.emplace_back(buffer, all.size());
+                    all.push_back(b);
+                }
+                raws.push_back(Raw{ type, nullptr, total, buffer + 1 });
+            }
+
+            // blocks are independent, each decompressing into its own slot of the file's buffer
+            std::vector<char> ok(work.size(), 1);
+            pool_.parallelFor(work.size(), [&](size_t b, size_t e, int)
+            {
+                for (size_t i = b; i < e; i++)
+                {
+                    const auto& blk = all[work[i].second];
+                    uint8_t* dst = buffers_[work[i].first].data() + blk.dstOffset;
+                    if (blk.srcSize == blk.dstSize)
+                        std::memcpy(dst, blk.src, blk.dstSize);
+                    else if (!rawpkg::lzo1xDecompress(blk.src, blk.srcSize, dst, blk.dstSize))
+                        ok[i] = 0;
+                    if (ok[i] && verify && blk.checkType)
+                    {
+                        const uint32_t c = (blk.checkType == 1) ? rawpkg::adler32(1, dst, blk.dstSize) : rawpkg::crc32(0, dst, blk.dstSize);
+                        ok[i] = (c == blk.check);
+                    }
+                }
+            });
+            if (std::find(ok.begin(), ok.end(), 0) != ok.end())
+            {
+                close();
+                return false;
+            }
+
+            for (auto& r : raws)
+            {
+                if (r.buffer)
+                    r.data = buffers_[r.buffer - 1].data();
+                if (!index(r.type, r.data, r.size))
+                {
+                    close();
+                    return false;
+                }
+            }
+
+            // order all frames by timestamp, keeping the per type lists in step
+            std::stable_sort(frames_.begin(), frames_.end(), [](const RawFrame& a, const RawFrame& b) { return a.tm < b.tm; });
+            for (size_t i = 0; i < frames_.size(); i++)
+                types_[frames_[i].type].push_back(i);
+            return true;
+        }
+
+        /// indexes the frames of a raw file
+        /// @param[in] type the data type
+        /// @param[in] data the raw file
+        /// @param[in] size size of the raw file
+        /// @return success of the call
+        bool index(RawType type, const uint8_t* data, size_t size)
+        {
+            if (size < sizeof(rawpkg::RawHeader))
+                return false;
+            rawpkg::RawHeader hdr;
+            hdr.id = static_cast<int32_t>(rawpkg::le32(data));
+            hdr.frames = static_cast<int32_t>(rawpkg::le32(data + 4));
+            hdr.lines = static_cast<int32_t>(rawpkg::le32(data + 8));
+            hdr.samples = static_cast<int32_t>(rawpkg::le32(data + 12));
+            hdr.sampleSize = static_cast<int32_t>(rawpkg::le32(data + 16));
+            if (hdr.frames < 0 || hdr.lines < 0 || hdr.samples < 0 || hdr.sampleSize < 0)
+                return false;
+
+            // the header fields are untrusted, reject any frame layout the file cannot hold before multiplying further
+            const size_t avail = size - sizeof(rawpkg::RawHeader);
+            const size_t lines = static_cast<size_t>(hdr.lines), samples = static_cast<size_t>(hdr.samples), sampleSize = static_cast<size_t>(hdr.sampleSize);
+            if (samples && lines > avail / samples)
+                return false;
+            if (sampleSize && lines * samples > avail / sampleSize)
+                return false;
+            const size_t frameSize = lines * samples * sampleSize;
+            if (!hdr.frames)
+                return true;
+            if (avail < sizeof(int64_t) || frameSize > avail - sizeof(int64_t) || static_cast<size_t>(hdr.frames) > avail / (sizeof(int64_t) + frameSize))
+                return false;
+
+            size_t pos = sizeof(rawpkg::RawHeader);
+            for (int32_t f = 0; f < hdr.frames; f++)
+            {
+                int64_t tm;
+                std::memcpy(&tm, data + pos, sizeof(tm));
+                pos += sizeof(tm);
+                frames_.push_back(RawFrame{ type, static_cast<long long int>(tm), hdr.lines, hdr.samples, hdr.sampleSize, data + pos, frameSize });
+                pos += frameSize;
+            }
+            return true;
+        }
+
+    private:
+        ThreadPool pool_;                               ///< decompression threads
+        MappedFile file_;                               ///< mapped package file
+        std::vector<std::vector<uint8_t>> buffers_;     ///< decompressed raw files
+        std::vector<RawFrame> frames_;                  ///< all frames, ordered by timestamp
+        std::vector<size_t> types_[RawTypes];           ///< frame indices per type
+        std::vector<RawPackageFile> files_;             ///< other files of the package
+    };
+}
@@ -0,0 +1,617 @@
+#pragma once
+
+#include "solum_def.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/// session recording
+///
+/// a recording is an append-only container of chunks, one per frame or imu sample, each holding the
+/// information structure delivered with the callback, any positional data, and the payload. once the
+/// recording is closed, an index of every chunk is appended along with a footer pointing to it, which
+/// allows a reader to locate any frame without scanning. recordings that were not closed properly are
+/// still readable, as the index is then rebuilt by walking the chunks.
+///
+/// layout (native byte order):
+///   file header | chunk header, info, positions, payload (8 byte aligned) | ... | index entries | footer
+
+namespace solum
+{
+    /// stream types stored in a recording
+    enum RecordStream : uint32_t
+    {
+        RecordProcessed = StreamProcessed,  ///< processed images (CusProcessedImageInfo)
+        RecordRaw = StreamRaw,              ///< raw images (CusRawImageInfo)
+        RecordSpectral = StreamSpectral,    ///< spectral images (CusSpectralImageInfo)
+        RecordImu,                          ///< imu samples streamed separately from the images
+        RecordStreams                       ///< number of stream types
+    };
+
+    namespace record
+    {
+        static constexpr char FileMagic[8] = { 'C', 'U', 'S', 'R', 'E', 'C', '\0', '\0' };
+        static constexpr char IndexMagic[8] = { 'C', 'U', 'S', 'I', 'D', 'X', '\0', '\0' };
+        static constexpr uint32_t ChunkMagic = 0x4b4e4843;  ///< "CHNK"
+        /// container version, raised whenever the layout of the file or of a structure embedded in the chunks changes
+        static constexpr uint32_t Version = 2;
+
+        /// file header
+        struct FileHeader
+        {
+            char magic[8];      ///< file identifier
+            uint32_t version;   ///< container version
+            uint32_t reserved;  ///< reserved
+        };
+
+        /// chunk header, followed by info, positions and payload
+        struct ChunkHeader
+        {
+            uint32_t magic;     ///< chunk identifier
+            uint32_t stream;    ///< stream type
+            uint32_t infoSize;  ///< size of the information structure
+            uint32_t npos;      ///< number of positional data
+            uint64_t size;      ///< size of the payload
+            int64_t tm;         ///< timestamp in nanoseconds
+        };
+
+        /// index entry
+        struct IndexEntry
+        {
+            int64_t tm;         ///< timestamp in nanoseconds
+            uint64_t offset;    ///< offset of the chunk header from the start of the file
+            uint32_t stream;    ///< stream type
+            uint32_t reserved;  ///< reserved
+        };
+
+        /// footer
+        struct Footer
+        {
+            uint64_t indexOffset;   ///< offset of the first index entry
+            uint64_t count;         ///< number of index entries
+            char magic[8];          ///< index identifier
+        };
+
+        /// rounds a size up to the chunk alignment
+        /// @param[in] sz the size to align
+        /// @return the aligned size
+        inline uint64_t align(uint64_t sz) { return (sz + 7) & ~static_cast<uint64_t>(7); }
+
+        /// retrieves the expected information structure size for a stream
+        /// @param[in] stream the stream type
+        /// @return the size of the structure
+        inline uint32_t infoSize(uint32_t stream)
+        {
+            switch (stream)
+            {
+            case RecordProcessed: return sizeof(CusProcessedImageInfo);
+            case RecordRaw: return sizeof(CusRawImageInfo);
+            case RecordSpectral: return sizeof(CusSpectralImageInfo);
+            default: return 0;
+            }
+        }
+    }
+
+    /// records callback data to a session file
+    ///
+    /// the add functions match the callback signatures and are safe to call from any callback thread,
+    /// data is written through a buffered stream on the calling thread.
+    class Recorder
+    {
+    public:
+        Recorder() : file_(nullptr), offset_(0), lastTm_(0), bytes_(0), failed_(false) { }
+        ~Recorder() { close(); }
+
+        Recorder(const Recorder&) = delete;
+        Recorder& operator=(const Recorder&) = delete;
+
+        /// opens a new recording, replacing any existing file
+        /// @param[in] path the file path
+        /// @param[in] bufferSize size of the write buffer in bytes
+        /// @return success of the call
+        bool open(const std::string& path, size_t bufferSize = 8 * 1024 * 1024)
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            if (file_)
+                return false;
+            file_ = std::fopen(path.c_str(), "wb");
+            if (!file_)
+                return false;
+            buffer_.resize(bufferSize);
+            std::setvbuf(file_, buffer_.data(), _IOFBF, buffer_.size());
+
+            record::FileHeader hdr;
+            std::memcpy(hdr.magic, record::FileMagic, sizeof(hdr.magic));
+            hdr.version = record::Version;
+            hdr.reserved = 0;
+            offset_ = 0;
+            bytes_ = 0;
+            lastTm_ = 0;
+            failed_ = false;
+            index_.clear();
+            if (!write(&hdr, sizeof(hdr)))
+            {
+                std::fclose(file_);
+                file_ = nullptr;
+                return false;
+            }
+            return true;
+        }
+
+        /// writes the index and closes the recording
+        /// @return success of the call, fails if any write failed during the recording
+        bool close()
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            if (!file_)
+                return false;
+            if (failed_)
+            {
+                // the chunk offsets no longer match the file, an index would point at the wrong data
+                std::fclose(file_);
+                file_ = nullptr;
+                buffer_.clear();
+                buffer_.shrink_to_fit();
+                return false;
+            }
+
+            record::Footer footer;
+            footer.indexOffset = offset_;
+            footer.count = index_.size();
+            std::memcpy(footer.magic, record::IndexMagic, sizeof(footer.magic));
+            bool ok = (index_.empty() || write(index_.data(), index_.size() * sizeof(record::IndexEntry))) && write(&footer, sizeof(footer));
+            ok = (std::fclose(file_) == 0) && ok;
+            file_ = nullptr;
+            buffer_.clear();
+            buffer_.shrink_to_fit();
+            return ok;
+        }
+
+        /// @return true if a recording is open
+        bool isOpen() const
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            return file_ != nullptr;
+        }
+
+        /// @return the number of chunks recorded
+        size_t count() const
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            return index_.size();
+        }
+
+        /// @return the number of payload bytes recorded
+        uint64_t bytes() const
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            return bytes_;
+        }
+
+        /// records a processed image
+        /// @param[in] img the image data
+        /// @param[in] nfo the image information
+        /// @param[in] npos number of positional data
+        /// @param[in] pos the positional data
+        /// @return success of the call
+        bool addProcessed(const void* img, const CusProcessedImageInfo* nfo, int npos, const CusPosInfo* pos)
+        {
+            return add(RecordProcessed, nfo->tm, nfo, sizeof(*nfo), npos, pos, img, static_cast<uint64_t>(nfo->imageSize));
+        }
+
+        /// records a raw image
+        /// @param[in] img the image data
+        /// @param[in] nfo the image information
+        /// @param[in] npos number of positional data
+        /// @param[in] pos the positional data
+        /// @return success of the call
+        bool addRaw(const void* img, const CusRawImageInfo* nfo, int npos, const CusPosInfo* pos)
+        {
+            uint64_t sz = nfo->jpeg ? static_cast<uint64_t>(nfo->jpeg) :
+                static_cast<uint64_t>(nfo->lines) * static_cast<uint64_t>(nfo->samples) * static_cast<uint64_t>(nfo->bitsPerSample / 8);
+            return add(RecordRaw, nfo->tm, nfo, sizeof(*nfo), npos, pos, img, sz);
+        }
+
+        /// records a spectral image
+        /// @param[in] img the image data
+        /// @param[in] nfo the image information
+        /// @return success of the call
+        /// @note spectral blocks carry no timestamp, they are stamped with the latest timestamp recorded
+        bool addSpectral(const void* img, const CusSpectralImageInfo* nfo)
+        {
+            uint64_t sz = static_cast<uint64_t>(nfo->lines) * static_cast<uint64_t>(nfo->samples) * static_cast<uint64_t>(nfo->bitsPerSample / 8);
+            return add(RecordSpectral, -1, nfo, sizeof(*nfo), 0, nullptr, img, sz);
+        }
+
+        /// records an imu sample
+        /// @param[in] pos the positional data
+        /// @return success of the call
+        bool addImu(const CusPosInfo* pos)
+        {
+            return add(RecordImu, pos->tm, nullptr, 0, 1, pos, nullptr, 0);
+        }
+
+    private:
+        /// writes to the file and advances the offset
+        /// @param[in] data the data to write
+        /// @param[in] sz size of the data
+        /// @return success of the call
+        /// @note a failed write leaves the recording failed, as the data written in part shifts everything after it
+        bool write(const void* data, uint64_t sz)
+        {
+            if (sz && std::fwrite(data, 1, static_cast<size_t>(sz), file_) != sz)
+            {
+                failed_ = true;
+                return false;
+            }
+            offset_ += sz;
+            return true;
+        }
+
+        /// appends a chunk
+        /// @return success of the call
+        bool add(uint32_t stream, int64_t tm, const void* nfo, uint32_t infoSize, int npos, const CusPosInfo* pos, const void* data, uint64_t sz)
+        {
+            static const uint8_t padding[8] = { 0 };
+            std::lock_guard<std::mutex> lock(lock_);
+            if (!file_ || failed_)
+                return false;
+            if (!pos)
+                npos = 0;
+            if (!data)
+                sz = 0;
+            if (tm < 0)
+                tm = lastTm_;
+            else
+                lastTm_ = tm;
+
+            record::ChunkHeader hdr;
+            hdr.magic = record::ChunkMagic;
+            hdr.stream = stream;
+            hdr.infoSize = infoSize;
+            hdr.npos = static_cast<uint32_t>(npos);
+            hdr.size = sz;
+            hdr.tm = tm;
+
+            record::IndexEntry entry;
+            entry.tm = tm;
+            entry.offset = offset_;
+            entry.stream = stream;
+            entry.reserved = 0;
+
+            // info and positions are kept aligned so that a mapped reader can access them in place
+            auto meta = static_cast<uint64_t>(infoSize);
+            if (!write(&hdr, sizeof(hdr)) || !write(nfo, infoSize) || !write(padding, record::align(meta) - meta) ||
+                !write(pos, static_cast<uint64_t>(npos) * sizeof(CusPosInfo)) || !write(data, sz) || !write(padding, record::align(sz) - sz))
+                return false;
+
+            index_.push_back(entry);
+            bytes_ += sz;
+            return true;
+        }
+
+    private:
+        std::FILE* file_;                       ///< the output file
+        std::vector<char> buffer_;              ///< write buffer
+        std::vector<record::IndexEntry> index_; ///< index of the chunks written
+        uint64_t offset_;                       ///< current file offset
+        int64_t lastTm_;                        ///< latest timestamp recorded
+        uint64_t bytes_;                        ///< payload bytes recorded
+        bool failed_;                           ///< set by the first failed write, after which nothing more is recorded
+        mutable std::mutex lock_;               ///< serializes callbacks from different threads
+    };
+
+    /// read-only memory mapped file
+    class MappedFile
+    {
+    public:
+        MappedFile() : data_(nullptr), size_(0)
+#ifdef _WIN32
+            , file_(INVALID_HANDLE_VALUE), mapping_(nullptr)
+#endif
+        { }
+        ~MappedFile() { close(); }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        /// maps a file into memory
+        /// @param[in] path the file path
+        /// @return success of the call
+        bool open(const std::string& path)
+        {
+            close();
+#ifdef _WIN32
+            file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            LARGE_INTEGER sz;
+            if (file_ == INVALID_HANDLE_VALUE || !GetFileSizeEx(file_, &sz) || sz.QuadPart == 0)
+            {
+                close();
+                return false;
+            }
+            mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            data_ = mapping_ ? static_cast<const uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+            if (!data_)
+            {
+                close();
+                return false;
+            }
+            size_ = static_cast<size_t>(sz.QuadPart);
+#else
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                return false;
+            struct stat st;
+            if (::fstat(fd, &st) != 0 || st.st_size <= 0)
+            {
+                ::close(fd);
+                return false;
+            }
+            void* p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (p == MAP_FAILED)
+                return false;
+            data_ = static_cast<const uint8_t*>(p);
+            size_ = static_cast<size_t>(st.st_size);
+#endif
+            return true;
+        }
+
+        /// unmaps the file
+        void close()
+        {
+#ifdef _WIN32
+            if (data_)
+                UnmapViewOfFile(data_);
+            if (mapping_)
+                CloseHandle(mapping_);
+            if (file_ != INVALID_HANDLE_VALUE)
+                CloseHandle(file_);
+            mapping_ = nullptr;
+            file_ = INVALID_HANDLE_VALUE;
+#else
+            if (data_)
+                ::munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+            data_ = nullptr;
+            size_ = 0;
+        }
+
+        /// @return the mapped data, null if not mapped
+        const uint8_t* data() const { return data_; }
+        /// @return size of the mapped data
+        size_t size() const { return size_; }
+
+    private:
+        const uint8_t* data_;   ///< mapped data
+        size_t size_;           ///< mapped size
+#ifdef _WIN32
+        HANDLE file_;           ///< file handle
+        HANDLE mapping_;        ///< mapping handle
+#endif
+    };
+
+    /// view of a recorded chunk, pointing directly into the mapped file
+    struct RecordedFrame
+    {
+        RecordStream stream;        ///< stream type
+        long long int tm;           ///< timestamp in nanoseconds
+        const void* info;           ///< information structure matching the stream, null for imu samples
+        int npos;                   ///< number of positional data
+        const CusPosInfo* pos;      ///< positional data
+        const void* data;           ///< payload
+        uint64_t size;              ///< size of the payload
+
+        /// @return the processed image information, null if not a processed image
+        const CusProcessedImageInfo* processed() const { return stream == RecordProcessed ? static_cast<const CusProcessedImageInfo*>(info) : nullptr; }
+        /// @return the raw image information, null if not a raw image
+        const CusRawImageInfo* raw() const { return stream == RecordRaw ? static_cast<const CusRawImageInfo*>(info) : nullptr; }
+        /// @return the spectral image information, null if not a spectral image
+        const CusSpectralImageInfo* spectral() const { return stream == RecordSpectral ? static_cast<const CusSpectralImageInfo*>(info) : nullptr; }
+    };
+
+    /// reads a session file through a memory mapping
+    class RecordReader
+    {
+    public:
+        RecordReader() : error_("") { }
+
+        /// opens a recording
+        /// @param[in] path the file path
+        /// @return success of the call, see error() for the reason of a failure
+        bool open(const std::string& path)
+        {
+            index_.clear();
+            for (auto& s : streams_)
+                s.clear();
+            error_ = "";
+            if (!file_.open(path))
+            {
+                error_ = "file could not be mapped";
+                return false;
+            }
+
+            record::FileHeader hdr;
+            if (file_.size() < sizeof(hdr))
+            {
+                error_ = "file too short";
+                return false;
+            }
+            std::memcpy(&hdr, file_.data(), sizeof(hdr));
+            if (std::memcmp(hdr.magic, record::FileMagic, sizeof(hdr.magic)) != 0)
+            {
+                error_ = "not a recording";
+                return false;
+            }
+            // chunks embed the information structures, which only match those of the same container version
+            if (hdr.version != record::Version)
+            {
+                error_ = (hdr.version < record::Version) ? "recorded with an older, unsupported version" : "recorded with a newer, unsupported version";
+                return false;
+            }
+
+            if (!loadIndex())
+                rebuildIndex();
+
+            for (size_t i = 0; i < index_.size(); i++)
+            {
+                if (index_[i].stream < RecordStreams)
+                    streams_[index_[i].stream].push_back(i);
+            }
+            // frames usually arrive in order, sort per stream in case they did not
+            for (auto& s : streams_)
+            {
+                std::stable_sort(s.begin(), s.end(), [this](size_t a, size_t b) { return index_[a].tm < index_[b].tm; });
+            }
+            return true;
+        }
+
+        /// closes the recording
+        void close()
+        {
+            file_.close();
+            index_.clear();
+            for (auto& s : streams_)
+                s.clear();
+        }
+
+        /// @return the reason the latest open failed, empty if it succeeded
+        const char* error() const { return error_; }
+
+        /// @return the total number of chunks in recording order
+        size_t count() const { return index_.size(); }
+
+        /// @param[in] stream the stream type
+        /// @return the number of chunks of a stream
+        size_t count(RecordStream stream) const { return stream < RecordStreams ? streams_[stream].size() : 0; }
+
+        /// retrieves a chunk in recording order
+        /// @param[in] i the chunk number
+        /// @param[out] frame holds the view of the chunk
+        /// @return success of the call
+        bool frame(size_t i, RecordedFrame& frame) const
+        {
+            return i < index_.size() && view(index_[i].offset, frame);
+        }
+
+        /// retrieves a chunk of a stream in timestamp order
+        /// @param[in] stream the stream type
+        /// @param[in] i the frame number within the stream
+        /// @param[out] frame holds the view of the chunk
+        /// @return success of the call
+        bool frame(RecordStream stream, size_t i, RecordedFrame& frame) const
+        {
+            return stream < RecordStreams && i < streams_[stream].size() && view(index_[streams_[stream][i]].offset, frame);
+        }
+
+        /// finds the first frame of a stream at or after a timestamp
+        /// @param[in] stream the stream type
+        /// @param[in] tm the timestamp in nanoseconds
+        /// @return the frame number within the stream, count(stream) if there is no such frame
+        size_t seek(RecordStream stream, long long int tm) const
+        {
+            if (stream >= RecordStreams)
+                return 0;
+            const auto& s = streams_[stream];
+            auto it = std::lower_bound(s.begin(), s.end(), tm, [this](size_t i, long long int t) { return index_[i].tm < t; });
+            return static_cast<size_t>(it - s.begin());
+        }
+
+    private:
+        /// loads the index from the footer
+        /// @return success of the call
+        bool loadIndex()
+        {
+            record::Footer footer;
+            if (file_.size() < sizeof(record::FileHeader) + sizeof(footer))
+                return false;
+            std::memcpy(&footer, file_.data() + file_.size() - sizeof(footer), sizeof(footer));
+            if (std::memcmp(footer.magic, record::IndexMagic, sizeof(footer.magic)) != 0)
+                return false;
+            auto end = file_.size() - sizeof(footer);
+            if (footer.indexOffset > end || footer.count > (end - footer.indexOffset) / sizeof(record::IndexEntry))
+                return false;
+            index_.resize(static_cast<size_t>(footer.count));
+            if (!index_.empty())
+                std::memcpy(index_.data(), file_.data() + footer.indexOffset, index_.size() * sizeof(record::IndexEntry));
+            return true;
+        }
+
+        /// rebuilds the index by walking the chunks, used when the recording was not closed
+        void rebuildIndex()
+        {
+            index_.clear();
+            uint64_t offset = sizeof(record::FileHeader);
+            RecordedFrame frame;
+            while (view(offset, frame))
+            {
+                record::ChunkHeader hdr;
+                std::memcpy(&hdr, file_.data() + offset, sizeof(hdr));
+                record::IndexEntry entry;
+                entry.tm = hdr.tm;
+                entry.offset = offset;
+                entry.stream = hdr.stream;
+                entry.reserved = 0;
+                index_.push_back(entry);
+                offset += chunkSize(hdr);
+            }
+        }
+
+        /// calculates the full size of a chunk
+        /// @param[in] hdr the chunk header
+        /// @return size of the chunk including its header
+        static uint64_t chunkSize(const record::ChunkHeader& hdr)
+        {
+            return sizeof(hdr) + record::align(hdr.infoSize) + static_cast<uint64_t>(hdr.npos) * sizeof(CusPosInfo) + record::align(hdr.size);
+        }
+
+        /// creates a view of the chunk at an offset, validating it against the file bounds
+        /// @param[in] offset the offset of the chunk header
+        /// @param[out] frame holds the view
+        /// @return success of the call
+        bool view(uint64_t offset, RecordedFrame& frame) const
+        {
+            record::ChunkHeader hdr;
+            if (offset > file_.size() || file_.size() - offset < sizeof(hdr))
+                return false;
+            std::memcpy(&hdr, file_.data() + offset, sizeof(hdr));
+            if (hdr.magic != record::ChunkMagic || hdr.stream >= RecordStreams || hdr.infoSize != record::infoSize(hdr.stream) ||
+                hdr.size > file_.size() || hdr.npos > file_.size() / sizeof(CusPosInfo) || chunkSize(hdr) > file_.size() - offset)
+                return false;
+
+            auto p = file_.data() + offset + sizeof(hdr);
+            frame.stream = static_cast<RecordStream>(hdr.stream);
+            frame.tm = hdr.tm;
+            frame.info = hdr.infoSize ? p : nullptr;
+            p += record::align(hdr.infoSize);
+            frame.npos = static_cast<int>(hdr.npos);
+            frame.pos = hdr.npos ? reinterpret_cast<const CusPosInfo*>(p) : nullptr;
+            p += static_cast<uint64_t>(hdr.npos) * sizeof(CusPosInfo);
+            frame.data = hdr.size ? p : nullptr;
+            frame.size = hdr.size;
+            return true;
+        }
+
+    private:
+        MappedFile file_;                                   ///< the mapped recording
+        std::vector<record::IndexEntry> index_;             ///< chunks in recording order
+        std::vector<size_t> streams_[RecordStreams];        ///< chunk numbers per stream in timestamp order
+        const char* error_;                                 ///< reason the latest open failed
+    };
+}
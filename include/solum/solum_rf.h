@@ -0,0 +1,483 @@
+#pragma once
+
+#include "solum_def.h"
+#include "solum_parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/// rf signal processing
+///
+/// processes whole rf frames as delivered through the raw image callback in RfMode, 16 bit samples stored line by
+/// line. lines are processed in parallel on a thread pool, and the per line kernels are written as flat loops over
+/// contiguous float buffers such that the compiler vectorizes them. build with full optimizations (-O3 with gcc, whose
+/// -O2 skips loops that need alias checks, /O2 with msvc) and preferably with the target's vector extensions enabled,
+/// i.e. -mavx2. filters are designed once per configuration.
+namespace solum
+{
+    namespace rf
+    {
+        static constexpr double SpeedOfSound = 1540.0;  ///< speed of sound assumed by the imaging, in m/s
+        static constexpr double Pi = 3.14159265358979323846;
+
+        /// calculates the sampling frequency of the rf data, each sample spanning a round trip through the tissue
+        /// @param[in] axialSize the axial microns per sample
+        /// @return the sampling frequency in hz
+        inline double samplingFrequency(double axialSize)
+        {
+            return (axialSize > 0) ? SpeedOfSound / (2.0 * axialSize * 1e-6) : 0;
+        }
+
+        /// designs the positive odd taps of a hamming windowed hilbert transformer, the even taps being zero and the
+        /// negative taps mirrored with opposite sign
+        /// @param[in] half the number of odd taps, the filter spanning 4 * half - 1 samples
+        /// @return the taps h(1), h(3), h(5), ...
+        inline std::vector<float> hilbert(int half)
+        {
+            std::vector<float> h(static_cast<size_t>(half));
+            const double span = 2.0 * half;
+            for (int i = 0; i < half; i++)
+            {
+                const int n = 2 * i + 1;
+                const double win = 0.54 + 0.46 * std::cos(Pi * n / span);
+                h[static_cast<size_t>(i)] = static_cast<float>(2.0 / (Pi * n) * win);
+            }
+            return h;
+        }
+
+        /// designs a hamming windowed sinc low pass filter with unity gain at dc
+        /// @param[in] half the number of taps on each side of the center tap
+        /// @param[in] cutoff the cutoff frequency as a fraction of the sampling frequency (0 - 0.5)
+        /// @return the 2 * half + 1 taps
+        inline std::vector<float> lowpass(int half, double cutoff)
+        {
+            std::vector<double> h(static_cast<size_t>(2 * half + 1));
+            double sum = 0;
+            for (int n = -half; n <= half; n++)
+            {
+                const double s = n ? std::sin(2.0 * Pi * cutoff * n) / (Pi * n) : 2.0 * cutoff;
+                const double win = 0.54 + 0.46 * std::cos(Pi * n / (half + 1));
+                h[static_cast<size_t>(n + half)] = s * win;
+                sum += s * win;
+            }
+            std::vector<float> out(h.size());
+            for (size_t i = 0; i < h.size(); i++)
+                out[i] = static_cast<float>(h[i] / sum);
+            return out;
+        }
+
+        /// calculates the gain that undoes the tgc applied to each sample
+        /// @param[in] tgc the tgc points supplied with the frame, ordered by depth, unused points following with a
+        ///               depth that does not increase
+        /// @param[in] samples the number of samples per line
+        /// @param[in] axialSize the axial microns per sample
+        /// @param[out] gains holds the linear gain of each sample
+        inline void tgcGains(const CusTgcInfo* tgc, int samples, double axialSize, std::vector<float>& gains)
+        {
+            gains.assign(static_cast<size_t>(samples), 1.0f);
+            if (!tgc)
+                return;
+            int n = 0;
+            while (n < CUS_MAXTGC && (n == 0 || tgc[n].depth > tgc[n - 1].depth))
+                n++;
+
+            int p = 0;
+            for (int i = 0; i < samples; i++)
+            {
+                const double depth = i * axialSize * 1e-3;
+                while (p + 1 < n && tgc[p + 1].depth <= depth)
+                    p++;
+                double db = tgc[p].gain;
+                if (p + 1 < n && depth > tgc[p].depth)
+                    db += (tgc[p + 1].gain - tgc[p].gain) * (depth - tgc[p].depth) / (tgc[p + 1].depth - tgc[p].depth);
+                gains[static_cast<size_t>(i)] = static_cast<float>(std::pow(10.0, -db / 20.0));
+            }
+        }
+
+        /// approximates the base 2 logarithm, accurate to about 5e-5 for positive finite values and written such that
+        /// loops calling it vectorize
+        /// @param[in] v the value
+        /// @return the logarithm, about -127 for zero
+        inline float log2(float v)
+        {
+            int32_t bits;
+            std::memcpy(&bits, &v, sizeof(bits));
+            const float e = static_cast<float>((bits >> 23) & 0xff) - 127.0f;
+            bits = (bits & 0x007fffff) | 0x3f800000;
+            float m;
+            std::memcpy(&m, &bits, sizeof(m));
+            // log2(m) / (m - 1) interpolated at chebyshev nodes over [1, 2)
+            float r = 5.86649397e-2f;
+            r = r * m - 4.59762784e-1f;
+            r = r * m + 1.46789775f;
+            r = r * m - 2.50788156f;
+            r = r * m + 2.88368556f;
+            return e + r * (m - 1.0f);
+        }
+    }
+
+    /// rf processing parameters
+    struct RfParams
+    {
+        double frequency;       ///< demodulation frequency in hz, 0 to estimate it from the first frame demodulated
+        double bandwidth;       ///< fractional bandwidth kept by demodulation (0 - 2)
+        int decimation;         ///< decimation factor applied to envelope and iq outputs, 1 to keep the sampling rate
+        int hilbertTaps;        ///< number of odd hilbert taps, trading accuracy at low frequencies for speed
+        int filterTaps;         ///< number of taps on each side of the low pass filters
+        double dynamicRange;    ///< dynamic range of log compression in db
+        double reference;       ///< envelope value mapped to full scale by log compression, 0 for the full rf scale
+        bool tgc;               ///< flag to undo the tgc applied during acquisition, using the tgc points of the frame
+    };
+
+    /// @return the default rf processing parameters
+    inline RfParams defaultRfParams()
+    {
+        RfParams p;
+        p.frequency = 0;
+        p.bandwidth = 1.0;
+        p.decimation = 1;
+        p.hilbertTaps = 16;
+        p.filterTaps = 16;
+        p.dynamicRange = 60;
+        p.reference = 0;
+        p.tgc = false;
+        return p;
+    }
+
+    /// processes rf frames into envelope, iq or log compressed b-mode data
+    /// @note calls into the same processor must be serialized, processors do not share state
+    class RfProcessor
+    {
+    public:
+        /// default constructor
+        /// @param[in] threads the number of threads lines are processed on, 0 to use the number of hardware threads
+        explicit RfProcessor(int threads = 0) : pool_(threads), lines_(0), samples_(0), fs_(0), f0_(0)
+        {
+            params_ = defaultRfParams();
+        }
+
+        /// prepares the processor for a frame format, cheap when nothing changed and thus safe to call every frame
+        /// @param[in] nfo the raw image information supplied with the frame
+        /// @param[in] params the processing parameters
+        /// @return success of the call, fails for anything but 16 bit rf data
+        bool configure(const CusRawImageInfo& nfo, const RfParams& params)
+        {
+            if (!nfo.rf || nfo.bitsPerSample != 16 || nfo.lines <= 0 || nfo.samples <= 0 || nfo.axialSize <= 0)
+                return false;
+
+            const bool format = (nfo.lines != lines_ || nfo.samples != samples_ || nfo.axialSize != axialSize_);
+            const bool filters = format || params.hilbertTaps != params_.hilbertTaps || params.filterTaps != params_.filterTaps ||
+                params.decimation != params_.decimation || params.bandwidth != params_.bandwidth || params.frequency != params_.frequency;
+            const bool tgc = format || params.tgc != params_.tgc || (params.tgc && std::memcmp(nfo.tgc, tgc_, sizeof(tgc_)));
+            params_ = params;
+            params_.decimation = std::max(1, params_.decimation);
+            params_.hilbertTaps = std::max(1, params_.hilbertTaps);
+            params_.filterTaps = std::max(1, params_.filterTaps);
+
+            if (format)
+            {
+                lines_ = nfo.lines;
+                samples_ = nfo.samples;
+                axialSize_ = nfo.axialSize;
+                fs_ = rf::samplingFrequency(nfo.axialSize);
+            }
+            if (filters)
+            {
+                hilbert_ = rf::hilbert(params_.hilbertTaps);
+                // the envelope occupies about as much bandwidth as the signal, which the decimated rate must hold
+                envFilter_ = rf::lowpass(params_.filterTaps, 0.4 / params_.decimation);
+                f0_ = params_.frequency;
+                iqFilter_.clear();
+                if (f0_ > 0)
+                    designDemodulation();
+                scratch_.assign(static_cast<size_t>(pool_.size()), Scratch());
+            }
+            if (tgc)
+            {
+                std::memcpy(tgc_, nfo.tgc, sizeof(tgc_));
+                if (params_.tgc)
+                    rf::tgcGains(nfo.tgc, samples_, axialSize_, gains_);
+                else
+                    gains_.assign(static_cast<size_t>(samples_), 1.0f);
+            }
+            return true;
+        }
+
+        /// @return the number of lines per frame
+        int lines() const { return lines_; }
+        /// @return the number of input samples per line
+        int samples() const { return samples_; }
+        /// @return the number of output samples per line, after decimation
+        int outputSamples() const { return (samples_ + params_.decimation - 1) / params_.decimation; }
+        /// @return the sampling frequency of the input in hz
+        double samplingFrequency() const { return fs_; }
+        /// @return the demodulation frequency in hz, 0 until estimated
+        double demodulationFrequency() const { return f0_; }
+
+        /// detects the envelope of a frame through the hilbert transform
+        /// @param[in] rf the rf frame, lines() * samples() samples
+        /// @param[out] out the envelope, lines() * outputSamples() values
+        void envelope(const int16_t* rf, float* out)
+        {
+            const size_t ns = static_cast<size_t>(outputSamples());
+            pool_.parallelFor(static_cast<size_t>(lines_), [&](size_t b, size_t e, int w)
+            {
+                for (size_t l = b; l < e; l++)
+                    envelopeLine(rf + l * samples_, out + l * ns, scratch_[static_cast<size_t>(w)]);
+            });
+        }
+
+        /// demodulates a frame to baseband
+        /// @param[in] rf the rf frame, lines() * samples() samples
+        /// @param[out] iq the interleaved in-phase and quadrature components, lines() * outputSamples() pairs
+        void demodulate(const int16_t* rf, float* iq)
+        {
+            if (f0_ <= 0)
+            {
+                f0_ = estimateFrequency(rf);
+                designDemodulation();
+            }
+            const size_t ns = static_cast<size_t>(outputSamples());
+            pool_.parallelFor(static_cast<size_t>(lines_), [&](size_t b, size_t e, int w)
+            {
+                for (size_t l = b; l < e; l++)
+                    demodulateLine(rf + l * samples_, iq + l * ns * 2, scratch_[static_cast<size_t>(w)]);
+            });
+        }
+
+        /// log compresses envelope data to 8 bits
+        /// @param[in] env the envelope, lines() * outputSamples() values
+        /// @param[out] out the compressed data, lines() * outputSamples() values
+        void compress(const float* env, uint8_t* out)
+        {
+            const size_t ns = static_cast<size_t>(outputSamples());
+            pool_.parallelFor(static_cast<size_t>(lines_), [&](size_t b, size_t e, int)
+            {
+                compressLine(env + b * ns, out + b * ns, (e - b) * ns);
+            });
+        }
+
+        /// detects and log compresses the envelope of a frame, without storing the intermediate envelope
+        /// @param[in] rf the rf frame, lines() * samples() samples
+        /// @param[out] out the b-mode data, lines() * outputSamples() values
+        void bmode(const int16_t* rf, uint8_t* out)
+        {
+            const size_t ns = static_cast<size_t>(outputSamples());
+            pool_.parallelFor(static_cast<size_t>(lines_), [&](size_t b, size_t e, int w)
+            {
+                auto& s = scratch_[static_cast<size_t>(w)];
+                s.line.resize(ns);
+                for (size_t l = b; l < e; l++)
+                {
+                    envelopeLine(rf + l * samples_, s.line.data(), s);
+                    compressLine(s.line.data(), out + l * ns, ns);
+                }
+            });
+        }
+
+    private:
+        /// per thread buffers
+        struct Scratch
+        {
+            std::vector<float> x;       ///< padded input line
+            std::vector<float> i;       ///< in-phase component, padded for filtering
+            std::vector<float> q;       ///< quadrature component, padded for filtering
+            std::vector<float> line;    ///< output line
+            std::vector<float> poly;    ///< polyphase components of a line being decimated
+            std::vector<float> acc;     ///< filter accumulators
+        };
+
+        /// converts a line to float, undoing the tgc, into a buffer padded with zeros on both sides
+        /// @param[in] rf the rf line
+        /// @param[out] x the padded buffer
+        /// @param[in] pad the number of samples to pad with
+        void load(const int16_t* rf, std::vector<float>& x, size_t pad) const
+        {
+            const size_t n = static_cast<size_t>(samples_);
+            x.assign(n + 2 * pad, 0.0f);
+            float* dst = x.data() + pad;
+            const float* g = gains_.data();
+            for (size_t i = 0; i < n; i++)
+                dst[i] = static_cast<float>(rf[i]) * g[i];
+        }
+
+        /// applies a low pass filter at the decimated positions of a padded buffer
+        /// @param[in] src the buffer, padded by the filter's half length
+        /// @param[in] h the filter
+        /// @param[out] dst the output, outputSamples() values spaced by stride
+        /// @param[in] stride the spacing of the output values
+        /// @param[in] s the thread's buffers
+        void decimate(const float* src, const std::vector<float>& h, float* dst, size_t stride, Scratch& s) const
+        {
+            const size_t ns = static_cast<size_t>(outputSamples()), d = static_cast<size_t>(params_.decimation), taps = h.size();
+            const size_t size = static_cast<size_t>(samples_) + taps - 1;
+
+            // split the input into its polyphase components, such that every tap reads a contiguous run of inputs
+            const float* poly = src;
+            const size_t len = ns + (taps + d - 1) / d;
+            if (d > 1)
+            {
+                s.poly.assign(d * len, 0.0f);
+                for (size_t i = 0; i < size; i++)
+                    s.poly[(i % d) * len + i / d] = src[i];
+                poly = s.poly.data();
+            }
+
+            s.acc.assign(ns, 0.0f);
+            float* acc = s.acc.data();
+            for (size_t k = 0; k < taps; k++)
+            {
+                const float c = h[k];
+                const float* in = poly + (k % d) * len + k / d;
+                for (size_t j = 0; j < ns; j++)
+                    acc[j] += c * in[j];
+            }
+            for (size_t j = 0; j < ns; j++)
+                dst[j * stride] = acc[j];
+        }
+
+        /// detects the envelope of a single line
+        /// @param[in] rf the rf line
+        /// @param[out] out the envelope, outputSamples() values
+        /// @param[in] s the thread's buffers
+        void envelopeLine(const int16_t* rf, float* out, Scratch& s) const
+        {
+            const size_t n = static_cast<size_t>(samples_);
+            const size_t half = hilbert_.size(), pad = 2 * half;
+            load(rf, s.x, pad);
+            const float* x = s.x.data() + pad;
+
+            // the hilbert transformer is odd, thus each tap pair weighs the difference of two samples
+            s.q.assign(n, 0.0f);
+            float* q = s.q.data();
+            for (size_t t = 0; t < half; t++)
+            {
+                const float h = hilbert_[t];
+                const size_t m = 2 * t + 1;
+                const float* a = x - m;
+                const float* b = x + m;
+                for (size_t i = 0; i < n; i++)
+                    q[i] += h * (a[i] - b[i]);
+            }
+
+            if (params_.decimation == 1)
+            {
+                for (size_t i = 0; i < n; i++)
+                    out[i] = std::sqrt(x[i] * x[i] + q[i] * q[i]);
+                return;
+            }
+
+            const size_t fpad = static_cast<size_t>(params_.filterTaps);
+            s.i.assign(n + 2 * fpad, 0.0f);
+            float* env = s.i.data() + fpad;
+            for (size_t i = 0; i < n; i++)
+                env[i] = std::sqrt(x[i] * x[i] + q[i] * q[i]);
+            decimate(s.i.data(), envFilter_, out, 1, s);
+        }
+
+        /// demodulates a single line
+        /// @param[in] rf the rf line
+        /// @param[out] iq the interleaved components, outputSamples() pairs
+        /// @param[in] s the thread's buffers
+        void demodulateLine(const int16_t* rf, float* iq, Scratch& s) const
+        {
+            const size_t n = static_cast<size_t>(samples_), pad = static_cast<size_t>(params_.filterTaps);
+            s.i.assign(n + 2 * pad, 0.0f);
+            s.q.assign(n + 2 * pad, 0.0f);
+            float* bi = s.i.data() + pad;
+            float* bq = s.q.data() + pad;
+            const float* c = cos_.data();
+            const float* sn = sin_.data();
+            const float* g = gains_.data();
+            for (size_t i = 0; i < n; i++)
+            {
+                const float v = static_cast<float>(rf[i]) * g[i];
+                bi[i] = v * c[i];
+                bq[i] = v * sn[i];
+            }
+            decimate(s.i.data(), iqFilter_, iq, 2, s);
+            decimate(s.q.data(), iqFilter_, iq + 1, 2, s);
+        }
+
+        /// log compresses envelope values
+        /// @param[in] env the envelope
+        /// @param[out] out the compressed values
+        /// @param[in] n the number of values
+        void compressLine(const float* env, uint8_t* out, size_t n) const
+        {
+            const double dr = std::max(1.0, params_.dynamicRange), ref = (params_.reference > 0) ? params_.reference : 32768.0;
+            // 20 * log10(v / ref) mapped from [-dr, 0] to [0, 255], expressed through log2
+            const float a = static_cast<float>(255.0 / dr * 20.0 * std::log10(2.0));
+            const float b = static_cast<float>(255.0 - a * std::log2(ref));
+            for (size_t i = 0; i < n; i++)
+            {
+                const float v = a * rf::log2(env[i]) + b;
+                out[i] = static_cast<uint8_t>(std::min(255.0f, std::max(0.0f, v + 0.5f)));
+            }
+        }
+
+        /// estimates the center frequency through the lag one autocorrelation of the analytic signal on the center line
+        /// @param[in] rf the rf frame
+        /// @return the frequency in hz
+        double estimateFrequency(const int16_t* rf)
+        {
+            Scratch& s = scratch_[0];
+            const size_t n = static_cast<size_t>(samples_), pad = 2 * hilbert_.size();
+            std::vector<float> env(n);
+            // computes the quadrature component into the scratch buffers as a side effect
+            auto dec = params_.decimation;
+            params_.decimation = 1;
+            envelopeLine(rf + static_cast<size_t>(lines_ / 2) * n, env.data(), s);
+            params_.decimation = dec;
+
+            const float* x = s.x.data() + pad;
+            const float* q = s.q.data();
+            double re = 0, im = 0;
+            for (size_t i = 1; i < n; i++)
+            {
+                re += static_cast<double>(x[i]) * x[i - 1] + static_cast<double>(q[i]) * q[i - 1];
+                im += static_cast<double>(q[i]) * x[i - 1] - static_cast<double>(x[i]) * q[i - 1];
+            }
+            const double f = std::atan2(im, re) / (2.0 * rf::Pi) * fs_;
+            return (f > 0) ? f : fs_ / 4.0;
+        }
+
+        /// designs the mixing tables and the baseband filter for the demodulation frequency
+        void designDemodulation()
+        {
+            const size_t n = static_cast<size_t>(samples_);
+            cos_.resize(n);
+            sin_.resize(n);
+            const double w = 2.0 * rf::Pi * f0_ / fs_;
+            // scaled by 2 to keep the amplitude of the rf signal
+            for (size_t i = 0; i < n; i++)
+            {
+                cos_[i] = static_cast<float>(2.0 * std::cos(w * static_cast<double>(i)));
+                sin_[i] = static_cast<float>(-2.0 * std::sin(w * static_cast<double>(i)));
+            }
+            const double cutoff = std::min(0.5 * params_.bandwidth * f0_ / fs_, 0.45 / params_.decimation);
+            iqFilter_ = rf::lowpass(params_.filterTaps, std::max(cutoff, 0.01));
+        }
+
+    private:
+        ThreadPool pool_;               ///< threads lines are processed on
+        RfParams params_;               ///< processing parameters
+        int lines_;                     ///< lines per frame
+        int samples_;                   ///< samples per line
+        double axialSize_ = 0;          ///< axial microns per sample
+        double fs_;                     ///< sampling frequency in hz
+        double f0_;                     ///< demodulation frequency in hz
+        CusTgcInfo tgc_[CUS_MAXTGC] = {}; ///< tgc points the gains were calculated for
+        std::vector<float> gains_;      ///< per sample tgc compensation
+        std::vector<float> hilbert_;    ///< odd hilbert taps
+        std::vector<float> envFilter_;  ///< envelope decimation filter
+        std::vector<float> iqFilter_;   ///< baseband filter
+        std::vector<float> cos_;        ///< in-phase mixing table
+        std::vector<float> sin_;        ///< quadrature mixing table
+        std::vector<Scratch> scratch_;  ///< per thread buffers
+    };
+}
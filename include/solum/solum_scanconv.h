@@ -0,0 +1,226 @@
+#pragma once
+
+#include "solum_def.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace solum
+{
+    /// prescan geometry required for scan conversion
+    struct ScanGeometry
+    {
+        int lines;              ///< number of lines
+        int samples;            ///< number of samples per line
+        double axialSize;       ///< axial microns per sample
+        double lateralSize;     ///< lateral microns per line, measured along the face of the probe
+        double radius;          ///< probe radius in millimeters, 0 for linear and phased array probes
+        double sector;          ///< angle spanned by the lines of a phased array probe in radians, 0 for linear and curved probes
+
+        bool operator==(const ScanGeometry& g) const
+        {
+            return lines == g.lines && samples == g.samples && axialSize == g.axialSize && lateralSize == g.lateralSize && radius == g.radius &&
+                sector == g.sector;
+        }
+        bool operator!=(const ScanGeometry& g) const { return !(*this == g); }
+    };
+
+    /// converts prescan (line-major) data into cartesian images
+    ///
+    /// the mapping from output pixels to prescan samples is computed once into a table holding, for every pixel that
+    /// falls within the field of view, its destination, the index of its top-left neighbour and four bilinear weights,
+    /// each in its own array. the table is only rebuilt when the geometry or output size changes, converting a frame is
+    /// then a single branch-free pass over the table. a converter produces one output size, use one per view.
+    ///
+    /// lines are laid out according to the probe: along an arc for curved probes (radius set), fanning out from the
+    /// center of the face for phased arrays (sector set), and side by side otherwise. neither the raw image information nor
+    /// the probe information tells phased arrays apart, so their geometry must be configured with the sector explicitly.
+    class ScanConverter
+    {
+    public:
+        ScanConverter() : geometry_(), width_(0), height_(0), scale_(0), originX_(0), originY_(0) { }
+
+        /// configures the converter from the callback information
+        /// @param[in] nfo the raw image information
+        /// @param[in] probe the probe information, supplying the radius
+        /// @param[in] width the output width in pixels
+        /// @param[in] height the output height in pixels
+        /// @return true if the table was rebuilt
+        /// @note a probe without radius is taken as linear, phased arrays need configuring with their sector
+        bool configure(const CusRawImageInfo& nfo, const CusProbeInfo& probe, int width, int height)
+        {
+            ScanGeometry g = { nfo.lines, nfo.samples, nfo.axialSize, nfo.lateralSize, static_cast<double>(probe.radius), 0 };
+            return configure(g, width, height);
+        }
+
+        /// configures the converter
+        /// @param[in] geometry the prescan geometry
+        /// @param[in] width the output width in pixels
+        /// @param[in] height the output height in pixels
+        /// @return true if the table was rebuilt
+        bool configure(const ScanGeometry& geometry, int width, int height)
+        {
+            if (geometry == geometry_ && width == width_ && height == height_)
+                return false;
+            geometry_ = geometry;
+            width_ = width;
+            height_ = height;
+            build();
+            return true;
+        }
+
+        /// converts a frame
+        /// @param[in] prescan the prescan data, lines * samples values stored line after line
+        /// @param[out] out the output image, width * height values, pixels outside the field of view are set to 0
+        /// @note the prescan data must match the configured geometry, and hold single channel 8 or 16 bit values, signed
+        ///       or not (i.e. envelope or iq data). jpeg compressed prescan data must be decoded first (see solum_jpeg.h)
+        template <typename T>
+        void convert(const T* prescan, T* out) const
+        {
+            static_assert(std::is_integral<T>::value && sizeof(T) <= 2, "prescan values must be 8 or 16 bit integers");
+            // signed values need a signed sum, the weights adding up to One keep the result within the range of T
+            using Sum = typename std::conditional<std::is_signed<T>::value, int64_t, uint64_t>::type;
+            std::memset(out, 0, static_cast<size_t>(width_) * height_ * sizeof(T));
+            const auto n = dst_.size();
+            const auto stride = static_cast<uint32_t>(geometry_.samples);
+            const uint32_t* dst = dst_.data();
+            const uint32_t* src = src_.data();
+            const uint16_t* w00 = w00_.data();
+            const uint16_t* w01 = w01_.data();
+            const uint16_t* w10 = w10_.data();
+            const uint16_t* w11 = w11_.data();
+
+            for (size_t i = 0; i < n; i++)
+            {
+                const T* p = prescan + src[i];
+                const Sum v = static_cast<Sum>(w00[i]) * p[0] + static_cast<Sum>(w01[i]) * p[1] +
+                    static_cast<Sum>(w10[i]) * p[stride] + static_cast<Sum>(w11[i]) * p[stride + 1];
+                out[dst[i]] = static_cast<T>((v + (One / 2)) >> Shift);
+            }
+        }
+
+        /// @return the output width in pixels
+        int width() const { return width_; }
+        /// @return the output height in pixels
+        int height() const { return height_; }
+        /// @return the output resolution, equal axially and laterally
+        double micronsPerPixel() const { return scale_; }
+        /// @return the horizontal position of the center of the probe face from the left of the image in microns
+        double originX() const { return originX_; }
+        /// @return the vertical position of the center of the probe face from the top of the image in microns
+        double originY() const { return originY_; }
+        /// @return the number of output pixels within the field of view
+        size_t size() const { return dst_.size(); }
+
+    private:
+        static constexpr int Shift = 8;             ///< weight precision in bits
+        static constexpr uint32_t One = 1 << Shift; ///< weight sum
+
+        /// rebuilds the interpolation table
+        void build()
+        {
+            dst_.clear();
+            src_.clear();
+            w00_.clear();
+            w01_.clear();
+            w10_.clear();
+            w11_.clear();
+            scale_ = originX_ = originY_ = 0;
+
+            const auto& g = geometry_;
+            if (g.lines < 2 || g.samples < 2 || g.axialSize <= 0 || g.lateralSize <= 0 || width_ <= 0 || height_ <= 0)
+                return;
+
+            // lines are centered on the probe face, positions in microns with y increasing with depth
+            const double center = (g.lines - 1) / 2.0;
+            const double depth = (g.samples - 1) * g.axialSize;
+            // phased arrays are handled as curved probes of no radius, their lines fanning out from the center of the face
+            const double r = (g.radius > 0) ? g.radius * 1000.0 : 0;
+            const bool curved = r > 0 || g.sector > 0;
+            const double pitch = (r > 0) ? g.lateralSize / r : (curved ? g.sector / (g.lines - 1) : 0);
+            double xmax, ymin;
+            if (curved)
+            {
+                const double a = std::min(center * pitch, 1.5707963267948966);
+                xmax = (r + depth) * std::sin(a);
+                ymin = r * std::cos(a) - r;
+            }
+            else
+            {
+                xmax = center * g.lateralSize;
+                ymin = 0;
+            }
+
+            // fit the field of view into the output while keeping the aspect ratio
+            scale_ = std::max((2.0 * xmax) / width_, (depth - ymin) / height_);
+            const double x0 = -xmax - (width_ * scale_ - 2.0 * xmax) / 2.0;
+            const double y0 = ymin;
+            originX_ = -x0;
+            originY_ = -y0;
+
+            const size_t reserve = static_cast<size_t>(width_) * height_;
+            dst_.reserve(reserve);
+            src_.reserve(reserve);
+            w00_.reserve(reserve);
+            w01_.reserve(reserve);
+            w10_.reserve(reserve);
+            w11_.reserve(reserve);
+
+            for (int y = 0; y < height_; y++)
+            {
+                const double py = y0 + (y + 0.5) * scale_;
+                for (int x = 0; x < width_; x++)
+                {
+                    const double px = x0 + (x + 0.5) * scale_;
+                    double line, sample;
+                    if (curved)
+                    {
+                        line = std::atan2(px, py + r) / pitch + center;
+                        sample = (std::hypot(px, py + r) - r) / g.axialSize;
+                    }
+                    else
+                    {
+                        line = px / g.lateralSize + center;
+                        sample = py / g.axialSize;
+                    }
+                    if (line < 0 || sample < 0 || line > g.lines - 1 || sample > g.samples - 1)
+                        continue;
+
+                    // keep the top-left neighbour inside the data so that the 2x2 footprint never reads past the end
+                    auto l = std::min(static_cast<int>(line), g.lines - 2);
+                    auto s = std::min(static_cast<int>(sample), g.samples - 2);
+                    const double fl = line - l, fs = sample - s;
+                    // truncating keeps the weights from summing past one, which would overflow the output type
+                    auto w11 = static_cast<uint32_t>(fl * fs * One);
+                    auto w10 = static_cast<uint32_t>(fl * (1.0 - fs) * One);
+                    auto w01 = static_cast<uint32_t>((1.0 - fl) * fs * One);
+                    auto w00 = One - (w11 + w10 + w01);
+
+                    dst_.push_back(static_cast<uint32_t>(y) * static_cast<uint32_t>(width_) + static_cast<uint32_t>(x));
+                    src_.push_back(static_cast<uint32_t>(l) * static_cast<uint32_t>(g.samples) + static_cast<uint32_t>(s));
+                    w00_.push_back(static_cast<uint16_t>(w00));
+                    w01_.push_back(static_cast<uint16_t>(w01));
+                    w10_.push_back(static_cast<uint16_t>(w10));
+                    w11_.push_back(static_cast<uint16_t>(w11));
+                }
+            }
+        }
+
+    private:
+        ScanGeometry geometry_;         ///< geometry the table was built for
+        int width_;                     ///< output width
+        int height_;                    ///< output height
+        double scale_;                  ///< microns per pixel
+        double originX_;                ///< horizontal origin in microns
+        double originY_;                ///< vertical origin in microns
+        std::vector<uint32_t> dst_;     ///< output pixel of each entry
+        std::vector<uint32_t> src_;     ///< top-left prescan neighbour of each entry
+        std::vector<uint16_t> w00_;     ///< weight of the top-left neighbour
+        std::vector<uint16_t> w01_;     ///< weight of the next sample
+        std::vector<uint16_t> w10_;     ///< weight of the next line
+        std::vector<uint16_t> w11_;     ///< weight of the next sample on the next line
+    };
+}
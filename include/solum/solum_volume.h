@@ -0,0 +1,516 @@
+#pragma once
+
+#include "solum_def.h"
+#include "solum_parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// freehand volume reconstruction
+///
+/// compounds tracked 2d frames into a voxel grid. each frame is placed by a pose mapping the image plane into the grid's
+/// coordinate system, i.e. the orientation of the imu (see solum_imu.h) or the acquisition angle of volumetric data.
+/// insertion walks the voxels around the image plane rather than the pixels, such that every voxel the plane crosses is
+/// reached regardless of the pixel and voxel sizes. the grid is split into columns along the axis closest to the plane's
+/// normal, which are grouped into tiles inserted in parallel without locking, as no two tiles share a voxel.
+///
+/// voxels hold a running weighted mean in 8.8 fixed point along with the accumulated weight, which saturates after about
+/// 255 full weights, thus 4 bytes per voxel. slices and maximum intensity projections are extracted as 8 bit images, the
+/// projections being cached and only recomputed where frames were inserted since the previous extraction.
+///
+/// coordinates are in microns: the image plane has its lateral axis along the pose's first column and its axial axis along
+/// the second, with the image origin (see CusProcessedImageInfo) at the pose's translation.
+namespace solum
+{
+    /// voxel insertion modes
+    enum VolumeInsertion : int
+    {
+        VolumeNearest,      ///< each voxel crossed by the plane takes the nearest pixel
+        VolumeWeighted      ///< voxels within a radius of the plane take the interpolated pixel, weighted by their distance
+    };
+
+    namespace volume
+    {
+        static constexpr int Tile = 16;     ///< edge of the tiles inserted and projected at once, in voxels
+
+        /// pose of an image plane
+        struct Pose
+        {
+            double r[9];    ///< row-major rotation, its columns being the lateral, axial and normal directions of the plane
+            double t[3];    ///< position of the image origin in microns
+        };
+
+        /// creates a pose from a quaternion
+        /// @param[in] q the orientation (w, x, y, z), normalized by the call
+        /// @param[in] t the position of the image origin in microns, nullptr for the origin of the coordinate system
+        /// @return the pose
+        inline Pose fromQuaternion(const double q[4], const double* t = nullptr)
+        {
+            double n = q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3];
+            n = (n > 0) ? 1.0 / std::sqrt(n) : 0.0;
+            const double w = q[0] * n, x = q[1] * n, y = q[2] * n, z = q[3] * n;
+            Pose p = { { 1 - 2 * (y * y + z * z), 2 * (x * y - w * z), 2 * (x * z + w * y),
+                         2 * (x * y + w * z), 1 - 2 * (x * x + z * z), 2 * (y * z - w * x),
+                         2 * (x * z - w * y), 2 * (y * z + w * x), 1 - 2 * (x * x + y * y) }, { 0, 0, 0 } };
+            for (int i = 0; t && i < 3; i++)
+                p.t[i] = t[i];
+            return p;
+        }
+
+        /// creates a pose from the acquisition angle of volumetric data, tilting the plane about its lateral axis
+        /// @param[in] angle the acquisition angle in degrees
+        /// @return the pose, the image origin being the center of rotation
+        inline Pose fromAngle(double angle)
+        {
+            const double a = angle * 3.14159265358979323846 / 180.0, c = std::cos(a), s = std::sin(a);
+            Pose p = { { 1, 0, 0, 0, c, -s, 0, s, c }, { 0, 0, 0 } };
+            return p;
+        }
+
+        /// computes an orientation relative to a reference, such that the reference frame lies in the grid's x-y plane
+        /// @param[in] ref the reference orientation (w, x, y, z), typically the first frame of a sweep
+        /// @param[in] q the orientation (w, x, y, z)
+        /// @param[out] out holds the relative orientation (w, x, y, z)
+        inline void relative(const double ref[4], const double q[4], double out[4])
+        {
+            // conjugate of the reference times the orientation
+            const double w = ref[0], x = -ref[1], y = -ref[2], z = -ref[3];
+            out[0] = w * q[0] - x * q[1] - y * q[2] - z * q[3];
+            out[1] = w * q[1] + x * q[0] + y * q[3] - z * q[2];
+            out[2] = w * q[2] - x * q[3] + y * q[0] + z * q[1];
+            out[3] = w * q[3] + x * q[2] - y * q[1] + z * q[0];
+        }
+    }
+
+    /// voxel grid compounding tracked frames
+    /// @note calls into the same volume must be serialized, i.e. frames inserted and images extracted from one thread
+    class Volume
+    {
+    public:
+        /// default constructor
+        /// @param[in] threads the number of threads frames are inserted on, 0 to use the number of hardware threads
+        explicit Volume(int threads = 0) : pool_(threads), voxel_(0), mode_(VolumeWeighted), radius_(1.0), generation_(0)
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                dims_[i] = 0;
+                bricks_[i] = 0;
+                origin_[i] = 0;
+            }
+        }
+
+        Volume(const Volume&) = delete;
+        Volume& operator=(const Volume&) = delete;
+
+        /// allocates an empty grid
+        /// @param[in] nx the number of voxels along x
+        /// @param[in] ny the number of voxels along y
+        /// @param[in] nz the number of voxels along z
+        /// @param[in] voxel the edge of a voxel in microns
+        /// @param[in] origin the position of the first voxel's center in microns, nullptr for the origin of the coordinate system
+        /// @return success of the call
+        bool configure(int nx, int ny, int nz, double voxel, const double* origin = nullptr)
+        {
+            if (nx <= 0 || ny <= 0 || nz <= 0 || voxel <= 0)
+                return false;
+            const int n[3] = { nx, ny, nz };
+            for (int i = 0; i < 3; i++)
+            {
+                dims_[i] = n[i];
+                bricks_[i] = (n[i] + volume::Tile - 1) / volume::Tile;
+                origin_[i] = origin ? origin[i] : 0;
+            }
+            voxel_ = voxel;
+            voxels_.assign(static_cast<size_t>(nx) * static_cast<size_t>(ny) * static_cast<size_t>(nz), Voxel());
+            stamps_.assign(static_cast<size_t>(bricks_[0]) * static_cast<size_t>(bricks_[1]) * static_cast<size_t>(bricks_[2]), 0);
+            for (int i = 0; i < 3; i++)
+            {
+                mip_[i].clear();
+                mipStamps_[i].clear();
+            }
+            generation_ = 0;
+            return true;
+        }
+
+        /// sets the insertion mode
+        /// @param[in] mode the insertion mode
+        void setMode(VolumeInsertion mode) { mode_ = mode; }
+        /// sets the radius around the plane within which voxels are weighted
+        /// @param[in] radius the radius in voxels, 1 by default
+        void setRadius(double radius) { radius_ = std::max(0.5, radius); }
+
+        /// empties the grid
+        void clear()
+        {
+            std::fill(voxels_.begin(), voxels_.end(), Voxel());
+            // stamps keep counting such that cached projections see the change
+            generation_++;
+            std::fill(stamps_.begin(), stamps_.end(), generation_);
+        }
+
+        /// @return the number of voxels along x
+        int width() const { return dims_[0]; }
+        /// @return the number of voxels along y
+        int height() const { return dims_[1]; }
+        /// @return the number of voxels along z
+        int depth() const { return dims_[2]; }
+        /// @return a counter increasing with every change to the grid, to tell whether images need to be extracted again
+        unsigned long long generation() const { return generation_; }
+
+        /// inserts an 8 bit grayscale frame
+        /// @param[in] img the image
+        /// @param[in] w the width of the image in pixels
+        /// @param[in] h the height of the image in pixels
+        /// @param[in] stride the size of an image row in bytes
+        /// @param[in] micronsPerPixel the pixel size
+        /// @param[in] originX the image origin in microns in the horizontal axis
+        /// @param[in] originY the image origin in microns in the vertical axis
+        /// @param[in] pose the pose of the image plane
+        /// @return success of the call
+        bool insert(const uint8_t* img, int w, int h, int stride, double micronsPerPixel, double originX, double originY, const volume::Pose& pose)
+        {
+            if (voxels_.empty() || !img || w <= 0 || h <= 0 || stride < w || micronsPerPixel <= 0)
+                return false;
+
+            Plane p;
+            p.img = img;
+            p.w = w;
+            p.h = h;
+            p.stride = stride;
+
+            // affine mapping of voxel indices to the distance from the plane (in microns) and to pixel coordinates
+            const double* r = pose.r;
+            const double rel[3] = { origin_[0] - pose.t[0], origin_[1] - pose.t[1], origin_[2] - pose.t[2] };
+            const double k = voxel_ / micronsPerPixel;
+            const double n[3] = { r[2], r[5], r[8] };
+            p.u0 = (r[0] * rel[0] + r[3] * rel[1] + r[6] * rel[2] + originX) / micronsPerPixel;
+            p.v0 = (r[1] * rel[0] + r[4] * rel[1] + r[7] * rel[2] + originY) / micronsPerPixel;
+            const double d0 = (n[0] * rel[0] + n[1] * rel[1] + n[2] * rel[2]) / voxel_;
+
+            // columns run along the axis closest to the normal, crossing the plane exactly once
+            int axis = 0;
+            for (int i = 1; i < 3; i++)
+                if (std::fabs(n[i]) > std::fabs(n[axis]))
+                    axis = i;
+            if (std::fabs(n[axis]) < 1e-9)
+                return false;
+            p.axis = axis;
+            p.a = (axis == 0) ? 1 : 0;
+            p.b = (axis == 2) ? 1 : 2;
+            const int ax[3] = { p.a, p.b, axis };
+            for (int i = 0; i < 3; i++)
+            {
+                p.du[i] = r[3 * ax[i]] * k;
+                p.dv[i] = r[3 * ax[i] + 1] * k;
+            }
+            // position of the plane along the column, as a function of the column
+            p.c0 = -d0 / n[axis];
+            p.ca = -n[p.a] / n[axis];
+            p.cb = -n[p.b] / n[axis];
+            // reach along the column for the weighted radius, and the distance to the plane per voxel along it
+            p.step = std::fabs(n[axis]);
+            p.reach = (mode_ == VolumeWeighted) ? radius_ / p.step : 0.5;
+
+            generation_++;
+            const int ta = bricks_[p.a], tb = bricks_[p.b];
+            pool_.parallelFor(static_cast<size_t>(ta) * static_cast<size_t>(tb), [&](size_t begin, size_t end, int)
+            {
+                for (size_t i = begin; i < end; i++)
+                    insertTile(p, static_cast<int>(i % static_cast<size_t>(ta)), static_cast<int>(i / static_cast<size_t>(ta)));
+            });
+            return true;
+        }
+
+        /// inserts a processed frame
+        /// @param[in] img the image
+        /// @param[in] nfo the image information supplied with the frame
+        /// @param[in] pose the pose of the image plane
+        /// @return success of the call, fails for anything but Uncompressed8Bit and Uncompressed images
+        bool insert(const void* img, const CusProcessedImageInfo& nfo, const volume::Pose& pose)
+        {
+            if (!img || nfo.width <= 0 || nfo.height <= 0)
+                return false;
+            if (nfo.format == Uncompressed8Bit && nfo.bitsPerPixel == 8)
+                return insert(static_cast<const uint8_t*>(img), nfo.width, nfo.height, nfo.width, nfo.micronsPerPixel, nfo.originX, nfo.originY, pose);
+            if (nfo.format != Uncompressed || nfo.bitsPerPixel != 32)
+                return false;
+
+            // argb frames are reduced to their luminance
+            const size_t n = static_cast<size_t>(nfo.width) * static_cast<size_t>(nfo.height);
+            gray_.resize(n);
+            const uint32_t* src = static_cast<const uint32_t*>(img);
+            for (size_t i = 0; i < n; i++)
+            {
+                const uint32_t px = src[i];
+                gray_[i] = static_cast<uint8_t>((((px >> 16) & 0xff) * 77 + ((px >> 8) & 0xff) * 150 + (px & 0xff) * 29 + 128) >> 8);
+            }
+            return insert(gray_.data(), nfo.width, nfo.height, nfo.width, nfo.micronsPerPixel, nfo.originX, nfo.originY, pose);
+        }
+
+        /// extracts a slice
+        /// @param[in] axis the axis normal to the slice (0 - 2 for x, y and z)
+        /// @param[in] index the index of the slice along the axis
+        /// @param[out] out holds the 8 bit slice, its rows running along the lower of the remaining axes, empty voxels being 0
+        /// @return success of the call
+        bool slice(int axis, int index, uint8_t* out)
+        {
+            if (!out || axis < 0 || axis > 2 || index < 0 || index >= dims_[axis] || voxels_.empty())
+                return false;
+            const int a = (axis == 0) ? 1 : 0, b = (axis == 2) ? 1 : 2;
+            const size_t sa = stride(a), sb = stride(b), base = static_cast<size_t>(index) * stride(axis);
+            const size_t na = static_cast<size_t>(dims_[a]);
+            pool_.parallelFor(static_cast<size_t>(dims_[b]), [&](size_t begin, size_t end, int)
+            {
+                for (size_t j = begin; j < end; j++)
+                {
+                    const Voxel* v = voxels_.data() + base + j * sb;
+                    uint8_t* dst = out + j * na;
+                    for (size_t i = 0; i < na; i++)
+                        dst[i] = value(v[i * sa].value);
+                }
+            });
+            return true;
+        }
+
+        /// extracts a maximum intensity projection, recomputing only the tiles changed since the previous call
+        /// @param[in] axis the axis projected along (0 - 2 for x, y and z)
+        /// @param[out] out holds the 8 bit projection, its rows running along the lower of the remaining axes
+        /// @return success of the call
+        bool mip(int axis, uint8_t* out)
+        {
+            if (!out || axis < 0 || axis > 2 || voxels_.empty())
+                return false;
+            const int a = (axis == 0) ? 1 : 0, b = (axis == 2) ? 1 : 2;
+            const size_t na = static_cast<size_t>(dims_[a]), nb = static_cast<size_t>(dims_[b]);
+            const int ta = bricks_[a], tb = bricks_[b];
+            std::vector<uint8_t>& img = mip_[axis];
+            std::vector<unsigned long long>& stamps = mipStamps_[axis];
+            if (img.size() != na * nb)
+            {
+                img.assign(na * nb, 0);
+                stamps.assign(static_cast<size_t>(ta) * static_cast<size_t>(tb), 0);
+            }
+
+            const size_t sa = stride(a), sb = stride(b), sc = stride(axis), nc = static_cast<size_t>(dims_[axis]);
+            pool_.parallelFor(static_cast<size_t>(ta) * static_cast<size_t>(tb), [&](size_t begin, size_t end, int)
+            {
+                for (size_t t = begin; t < end; t++)
+                {
+                    const int ia = static_cast<int>(t % static_cast<size_t>(ta)), ib = static_cast<int>(t / static_cast<size_t>(ta));
+                    unsigned long long latest = 0;
+                    for (int ic = 0; ic < bricks_[axis]; ic++)
+                    {
+                        int idx[3];
+                        idx[a] = ia;
+                        idx[b] = ib;
+                        idx[axis] = ic;
+                        latest = std::max(latest, stamps_[brick(idx)]);
+                    }
+                    if (latest <= stamps[t])
+                        continue;
+                    stamps[t] = latest;
+
+                    const size_t a0 = static_cast<size_t>(ia) * volume::Tile, a1 = std::min(na, a0 + volume::Tile);
+                    const size_t b0 = static_cast<size_t>(ib) * volume::Tile, b1 = std::min(nb, b0 + volume::Tile);
+                    for (size_t j = b0; j < b1; j++)
+                    {
+                        for (size_t i = a0; i < a1; i++)
+                        {
+                            const Voxel* v = voxels_.data() + i * sa + j * sb;
+                            uint16_t m = 0;
+                            for (size_t c = 0; c < nc; c++)
+                                m = std::max(m, v[c * sc].value);
+                            img[j * na + i] = value(m);
+                        }
+                    }
+                }
+            });
+            std::copy(img.begin(), img.end(), out);
+            return true;
+        }
+
+    private:
+        /// voxel, empty until it was first weighted
+        struct Voxel
+        {
+            uint16_t value = 0;     ///< weighted mean in 8.8 fixed point
+            uint16_t weight = 0;    ///< accumulated weight in 8.8 fixed point, saturating
+        };
+
+        /// frame being inserted, its mappings expressed along the column axes (a, b, c)
+        struct Plane
+        {
+            const uint8_t* img;     ///< image
+            int w;                  ///< image width
+            int h;                  ///< image height
+            int stride;             ///< image row size
+            int axis;               ///< column axis
+            int a;                  ///< lower of the remaining axes
+            int b;                  ///< higher of the remaining axes
+            double u0;              ///< horizontal pixel coordinate of the first voxel
+            double v0;              ///< vertical pixel coordinate of the first voxel
+            double du[3];           ///< horizontal pixel coordinate change per voxel along a, b and the column
+            double dv[3];           ///< vertical pixel coordinate change per voxel along a, b and the column
+            double c0;              ///< position of the plane along the first column
+            double ca;              ///< position change per column along a
+            double cb;              ///< position change per column along b
+            double step;            ///< distance to the plane per voxel along the column, in voxels
+            double reach;           ///< extent around the plane along the column, in voxels
+        };
+
+        /// @return the distance between neighbouring voxels along an axis
+        size_t stride(int axis) const
+        {
+            return (axis == 0) ? 1 : ((axis == 1) ? static_cast<size_t>(dims_[0]) : static_cast<size_t>(dims_[0]) * static_cast<size_t>(dims_[1]));
+        }
+
+        /// @return the index of a brick
+        size_t brick(const int idx[3]) const
+        {
+            return static_cast<size_t>(idx[0]) + static_cast<size_t>(bricks_[0]) * (static_cast<size_t>(idx[1]) + static_cast<size_t>(bricks_[1]) * static_cast<size_t>(idx[2]));
+        }
+
+        /// @return the 8 bit value of a voxel value
+        static uint8_t value(uint16_t v)
+        {
+            const unsigned int x = (v + 128u) >> 8;
+            return static_cast<uint8_t>(x > 255u ? 255u : x);
+        }
+
+        /// blends a sample into a voxel
+        /// @param[in,out] v the voxel
+        /// @param[in] x the sample in 8.8 fixed point
+        /// @param[in] w the weight in 8.8 fixed point
+        static void blend(Voxel& v, int x, unsigned int w)
+        {
+            const unsigned int total = v.weight + w;
+            v.value = static_cast<uint16_t>(v.value + ((x - static_cast<int>(v.value)) * static_cast<int>(w)) / static_cast<int>(total));
+            v.weight = static_cast<uint16_t>(std::min(total, 0xffffu));
+        }
+
+        /// inserts the part of a frame falling into a tile of columns
+        /// @param[in] p the frame
+        /// @param[in] ta the index of the tile along a
+        /// @param[in] tb the index of the tile along b
+        void insertTile(const Plane& p, int ta, int tb)
+        {
+            const int a0 = ta * volume::Tile, a1 = std::min(dims_[p.a], a0 + volume::Tile);
+            const int b0 = tb * volume::Tile, b1 = std::min(dims_[p.b], b0 + volume::Tile);
+            const int nc = dims_[p.axis];
+
+            // the mappings being affine, the tile's corners bound the pixels and column positions it covers
+            double cmin = 1e300, cmax = -1e300, umin = 1e300, umax = -1e300, vmin = 1e300, vmax = -1e300;
+            for (int corner = 0; corner < 4; corner++)
+            {
+                const double ia = (corner & 1) ? a1 - 1 : a0, ib = (corner & 2) ? b1 - 1 : b0;
+                const double c = p.c0 + p.ca * ia + p.cb * ib;
+                for (int side = -1; side <= 1; side += 2)
+                {
+                    const double cc = c + side * p.reach;
+                    const double u = p.u0 + p.du[0] * ia + p.du[1] * ib + p.du[2] * cc;
+                    const double v = p.v0 + p.dv[0] * ia + p.dv[1] * ib + p.dv[2] * cc;
+                    cmin = std::min(cmin, cc);
+                    cmax = std::max(cmax, cc);
+                    umin = std::min(umin, u);
+                    umax = std::max(umax, u);
+                    vmin = std::min(vmin, v);
+                    vmax = std::max(vmax, v);
+                }
+            }
+            if (cmax < -0.5 || cmin > nc - 0.5 || umax < -0.5 || umin > p.w - 0.5 || vmax < -0.5 || vmin > p.h - 0.5)
+                return;
+
+            const size_t sa = stride(p.a), sb = stride(p.b), sc = stride(p.axis);
+            const bool weighted = (mode_ == VolumeWeighted);
+            const double invRadius = 1.0 / radius_;
+            bool touched = false;
+            for (int ib = b0; ib < b1; ib++)
+            {
+                for (int ia = a0; ia < a1; ia++)
+                {
+                    const double c = p.c0 + p.ca * ia + p.cb * ib;
+                    const int first = std::max(0, static_cast<int>(std::ceil(c - p.reach))), last = std::min(nc - 1, static_cast<int>(std::floor(c + p.reach)));
+                    if (first > last)
+                        continue;
+                    Voxel* col = voxels_.data() + static_cast<size_t>(ia) * sa + static_cast<size_t>(ib) * sb;
+                    const double u = p.u0 + p.du[0] * ia + p.du[1] * ib, v = p.v0 + p.dv[0] * ia + p.dv[1] * ib;
+                    for (int ic = first; ic <= last; ic++)
+                    {
+                        const double x = u + p.du[2] * ic, y = v + p.dv[2] * ic;
+                        if (weighted)
+                        {
+                            const double d = std::fabs(ic - c) * p.step * invRadius;
+                            const unsigned int w = static_cast<unsigned int>((1.0 - d) * 256.0 + 0.5);
+                            int s;
+                            if (!w || !sample(p, x, y, s))
+                                continue;
+                            blend(col[static_cast<size_t>(ic) * sc], s, w);
+                        }
+                        else
+                        {
+                            const int px = static_cast<int>(std::floor(x + 0.5)), py = static_cast<int>(std::floor(y + 0.5));
+                            if (px < 0 || py < 0 || px >= p.w || py >= p.h)
+                                continue;
+                            blend(col[static_cast<size_t>(ic) * sc], p.img[static_cast<size_t>(py) * static_cast<size_t>(p.stride) + static_cast<size_t>(px)] << 8, 256);
+                        }
+                        touched = true;
+                    }
+                }
+            }
+            if (!touched)
+                return;
+
+            // tiles and bricks line up, so the tile is the only writer of the bricks it marks
+            const int c0 = std::max(0, static_cast<int>(std::floor(cmin))) / volume::Tile, c1 = std::min(nc - 1, static_cast<int>(std::ceil(cmax))) / volume::Tile;
+            for (int ic = c0; ic <= c1; ic++)
+            {
+                int idx[3];
+                idx[p.a] = ta;
+                idx[p.b] = tb;
+                idx[p.axis] = ic;
+                stamps_[brick(idx)] = generation_;
+            }
+        }
+
+        /// samples a frame with bilinear interpolation
+        /// @param[in] p the frame
+        /// @param[in] x the horizontal pixel coordinate
+        /// @param[in] y the vertical pixel coordinate
+        /// @param[out] s holds the sample in 8.8 fixed point
+        /// @return success of the call, fails outside of the image
+        static bool sample(const Plane& p, double x, double y, int& s)
+        {
+            if (x < -0.5 || y < -0.5 || x > p.w - 0.5 || y > p.h - 0.5)
+                return false;
+            // pixels along the border are extended by half a pixel
+            x = std::min(std::max(x, 0.0), p.w - 1.0);
+            y = std::min(std::max(y, 0.0), p.h - 1.0);
+            const int x0 = static_cast<int>(x), y0 = static_cast<int>(y);
+            const int x1 = std::min(x0 + 1, p.w - 1), y1 = std::min(y0 + 1, p.h - 1);
+            const int fx = static_cast<int>((x - x0) * 256.0 + 0.5), fy = static_cast<int>((y - y0) * 256.0 + 0.5);
+            const uint8_t* r0 = p.img + static_cast<size_t>(y0) * static_cast<size_t>(p.stride);
+            const uint8_t* r1 = p.img + static_cast<size_t>(y1) * static_cast<size_t>(p.stride);
+            const int top = r0[x0] * (256 - fx) + r0[x1] * fx, bottom = r1[x0] * (256 - fx) + r1[x1] * fx;
+            s = (top * (256 - fy) + bottom * fy + 128) >> 8;
+            return true;
+        }
+
+    private:
+        ThreadPool pool_;                               ///< insertion and extraction threads
+        int dims_[3];                                   ///< voxels along x, y and z
+        int bricks_[3];                                 ///< tiles along x, y and z
+        double origin_[3];                              ///< position of the first voxel in microns
+        double voxel_;                                  ///< voxel edge in microns
+        VolumeInsertion mode_;                          ///< insertion mode
+        double radius_;                                 ///< weighted insertion radius in voxels
+        unsigned long long generation_;                 ///< change counter
+        std::vector<Voxel> voxels_;                     ///< grid, x varying fastest
+        std::vector<unsigned long long> stamps_;        ///< generation of the latest change per brick
+        std::vector<uint8_t> gray_;                     ///< luminance of argb frames
+        std::vector<uint8_t> mip_[3];                   ///< cached projections per axis
+        std::vector<unsigned long long> mipStamps_[3];  ///< generation each projection tile was computed at
+    };
+}